@@ -12,6 +12,7 @@ DialogProgress::DialogProgress(QWidget *parent) :
 
     connect(ui->buttonBox, SIGNAL(clicked(QAbstractButton*)), this, SLOT(handle_abortBtn(QAbstractButton*)));
     connect(ui->checkBox_hookFinishedEnabled, SIGNAL(toggled(bool)), this, SLOT(handle_postHookCheckboxChanged(bool)));
+    connect(ui->pushButton_pause, SIGNAL(toggled(bool)), this, SLOT(handle_pauseBtn(bool)));
 }
 
 DialogProgress::~DialogProgress()
@@ -24,6 +25,11 @@ void DialogProgress::enableHookCheckbox()
     ui->checkBox_hookFinishedEnabled->setEnabled(true);
 }
 
+void DialogProgress::enablePauseButton()
+{
+    ui->pushButton_pause->setEnabled(true);
+}
+
 void DialogProgress::handle_postHookCheckboxChanged(bool checked)
 {
     QSettings settings;
@@ -35,6 +41,19 @@ void DialogProgress::handle_updateProgress(int percent)
     ui->progressBar->setValue(percent);
 }
 
+void DialogProgress::handle_plotStatus(qint64 bytesSent, qint64 bytesTotal, double bytesPerSecond, double secondsRemaining)
+{
+    int minutes = (secondsRemaining / 60);
+    QString text = "Sent " + QString::number(bytesSent) + " of " + QString::number(bytesTotal) + " bytes, "
+            + QString::number(bytesPerSecond, 'f', 0) + " bytes/s, about ";
+    if (minutes)
+    {
+        text += QString::number(minutes) + "m ";
+    }
+    text += QString::number(static_cast<int>(secondsRemaining - (minutes*60))) + "s left";
+    ui->label_plotStatus->setText(text);
+}
+
 void DialogProgress::handle_abortBtn(QAbstractButton * btn)
 {
     if (btn->text() == "Abort")
@@ -42,3 +61,17 @@ void DialogProgress::handle_abortBtn(QAbstractButton * btn)
         emit do_cancel();
     }
 }
+
+void DialogProgress::handle_pauseBtn(bool checked)
+{
+    if (checked)
+    {
+        ui->pushButton_pause->setText("Resume");
+        emit do_pause();
+    }
+    else
+    {
+        ui->pushButton_pause->setText("Pause");
+        emit do_resume();
+    }
+}
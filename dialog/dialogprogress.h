@@ -7,6 +7,7 @@
 #include <QDialogButtonBox>
 #include <QAbstractButton>
 #include <QCheckBox>
+#include <QPushButton>
 
 #include "settings.h"
 
@@ -22,16 +23,21 @@ public:
     explicit DialogProgress(QWidget *parent = 0);
     ~DialogProgress();
     void enableHookCheckbox();
+    void enablePauseButton();
 
 signals:
     void do_cancel();
+    void do_pause();
+    void do_resume();
 
 public slots:
     void handle_updateProgress(int percent);
+    void handle_plotStatus(qint64 bytesSent, qint64 bytesTotal, double bytesPerSecond, double secondsRemaining);
 
 private slots:
     void handle_postHookCheckboxChanged(bool checked);
     void handle_abortBtn(QAbstractButton *btn);
+    void handle_pauseBtn(bool checked);
 
 private:
     Ui::DialogProgress *ui;
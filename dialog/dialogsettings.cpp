@@ -62,6 +62,13 @@ DialogSettings::DialogSettings(QWidget *parent) :
     }
     ui->comboBox_deviceWidthType->setCurrentIndex(0);
 
+    ui->comboBox_deviceEncoding->clear();
+    for (int i = 0; i < deviceEncoding_t::ENCODING_SIZE_OF_ENUM; ++i)
+    {
+        ui->comboBox_deviceEncoding->insertItem(i, deviceEncoding_names[i], i);
+    }
+    ui->comboBox_deviceEncoding->setCurrentIndex(0);
+
     do_refreshSerialList();
 
     // Load saved settings
@@ -78,6 +85,11 @@ DialogSettings::DialogSettings(QWidget *parent) :
     ui->spinBox_deviceTravelSpeed->setValue(settings.value("device/speed/travel", SETDEF_DEVICE_SPEED_TRAVEL).toInt());
     ui->spinBox_deviceWidth->setValue(settings.value("device/width", SETDEF_DEVICE_WIDTH).toInt());
     ui->comboBox_deviceWidthType->setCurrentIndex(settings.value("device/width/type", SETDEF_DEVICE_WDITH_TYPE).toInt());
+    ui->comboBox_deviceEncoding->setCurrentIndex(settings.value("device/encoding", SETDEF_DEVICE_ENCODING).toInt());
+    ui->doubleSpinBox_motionAccel->setValue(settings.value("device/motion/accel", SETDEF_DEVICE_MOTION_ACCEL).toDouble());
+    ui->doubleSpinBox_motionJunction->setValue(settings.value("device/motion/junction", SETDEF_DEVICE_MOTION_JUNCTION).toDouble());
+    ui->doubleSpinBox_motionPenDelay->setValue(settings.value("device/motion/pendelay", SETDEF_DEVICE_MOTION_PENDELAY).toDouble());
+    ui->doubleSpinBox_motionCmdDelay->setValue(settings.value("device/motion/cmddelay", SETDEF_DEVICE_MOTION_CMDDELAY).toDouble());
     ui->tabWidget->setCurrentIndex(settings.value("dialogsettings/index", SETDEF_DIALLOGSETTINGS_INDEX).toInt());
 
     oldCutoutBoxes = settings.value("device/cutoutboxes", SETDEF_DEVICE_CUTOUTBOXES).toBool();
@@ -285,6 +297,11 @@ void DialogSettings::do_saveAndClose()
         settings.setValue("speed/travel", ui->spinBox_deviceTravelSpeed->value());
         settings.setValue("width", ui->spinBox_deviceWidth->value());
         settings.setValue("width/type", ui->comboBox_deviceWidthType->currentData().toInt());
+        settings.setValue("encoding", ui->comboBox_deviceEncoding->currentData().toInt());
+        settings.setValue("motion/accel", ui->doubleSpinBox_motionAccel->value());
+        settings.setValue("motion/junction", ui->doubleSpinBox_motionJunction->value());
+        settings.setValue("motion/pendelay", ui->doubleSpinBox_motionPenDelay->value());
+        settings.setValue("motion/cmddelay", ui->doubleSpinBox_motionCmdDelay->value());
         settings.setValue("cutoutboxes", ui->checkBox_enableCutoutBoxes->isChecked());
         settings.setValue("cutoutboxes/padding", ui->doubleSpinBox_cutoutBoxesPadding->value());
         // Signal cutoutbox toggle if necessary
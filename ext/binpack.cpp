@@ -2,7 +2,10 @@
 
 ExtBinPack::ExtBinPack(hpglListModel *model)
 {
-    cancelFlag = false;
+    cancelFlag.store(0);
+    stopFlag.store(0);
+    incrementalFlag = false;
+    remnantsFlag = false;
     hpglModel = model;
 }
 
@@ -11,141 +14,708 @@ ExtBinPack::~ExtBinPack()
     //
 }
 
+/**
+ * @brief ExtBinPack::process
+ * Races every packer and heuristic over several orderings of the files on
+ * the global thread pool, and keeps the shortest layout that's ready by the deadline.
+ */
 void ExtBinPack::process()
 {
     QSettings settings;
-//    rbp::ShelfBinPack packer;
-    rbp::MaxRectsBinPack mrPacker;
-    QPersistentModelIndex index;
-    QGraphicsItemGroup * itemGroup;
+    QVector<QPersistentModelIndex> indexes;
+    QVector<QSizeF> sizes;
+    QElapsedTimer deadlineTimer;
+
+    if (incrementalFlag)
+    {
+        processIncremental();
+        return;
+    }
+    rotateFiles();
+    if (remnantsFlag)
+    {
+        processRemnants();
+        return;
+    }
 
-    hpglModel->sort();
+    deadlineTimer.start();
+    // The model and its views live on the main thread
+    QMetaObject::invokeMethod(hpglModel, "sort", Qt::BlockingQueuedConnection, Q_ARG(int, SORT_LONGEST_SIDE));
 
     int initX, initY;
     QLineF widthLine = MainWindow::get_widthLine();
     initX = widthLine.p2().y() - widthLine.p1().y();
     initY = 0;
 
-    for (int i = 0; i < hpglModel->rowCount(); ++i)
+    if (!fileSizes(hpglModel, indexes, sizes))
     {
-        if (cancelFlag)
+        emit finished();
+        return;
+    }
+    for (int i = 0; i < sizes.length(); ++i)
+    {
+        initY += qMax(sizes.at(i).width(), sizes.at(i).height());
+    }
+
+    if (sizes.isEmpty())
+    {
+        emit finished();
+        return;
+    }
+
+    // The strip packer doesn't need a bin length, and its result bounds the
+    // others: a layout longer than it is no use, so that's their bin length.
+    binpack_result bestResult;
+    hpglStripPacker stripPacker(initX);
+    bestResult.candidate.packer = PACKER_STRIP;
+    bestResult.candidate.heuristic = 0;
+    bestResult.candidate.split = 0;
+    bestResult.candidate.order = 0;
+    bestResult.nsecs = deadlineTimer.nsecsElapsed();
+    bestResult.ok = stripPacker.optimize(sizes, settings.value("binpack/strip", SETDEF_BINPACK_STRIP).toInt(),
+                                         bestResult.rects, bestResult.length);
+    bestResult.nsecs = deadlineTimer.nsecsElapsed() - bestResult.nsecs;
+    if (bestResult.ok)
+    {
+        statusUpdate("Strip packing: " + QString::number(bestResult.length / 1016.0, 'f', 1) + " inches in "
+                     + QString::number(bestResult.nsecs / 1000) + " us, "
+                     + QString::number(stripPacker.iterations()) + " orders tried.");
+        initY = qCeil(bestResult.length);
+    }
+
+    // Sort orders: the model's own (longest side), area, width, height, perimeter
+    QVector<QVector<int> > orders;
+    for (int key = 0; key < 5; ++key)
+    {
+        QVector<QPair<double, int> > keyed;
+        for (int i = 0; i < sizes.length(); ++i)
         {
-            statusUpdate("Cancelling auto arrange.", Qt::darkRed);
-            emit finished();
-            return;
+            double value;
+            switch (key)
+            {
+            case 0:
+                value = i;
+                break;
+            case 1:
+                value = -(sizes.at(i).width() * sizes.at(i).height());
+                break;
+            case 2:
+                value = -sizes.at(i).width();
+                break;
+            case 3:
+                value = -sizes.at(i).height();
+                break;
+            default:
+                value = -(sizes.at(i).width() + sizes.at(i).height());
+                break;
+            }
+            keyed.push_back(qMakePair(value, i));
         }
-        index = hpglModel->index(i);
-        itemGroup = NULL;
-        hpglModel->dataGroup(index, itemGroup);
-        hpglModel->mutexLock();
+        std::stable_sort(keyed.begin(), keyed.end());
+        QVector<int> order;
+        for (int i = 0; i < keyed.length(); ++i)
+        {
+            order.push_back(keyed.at(i).second);
+        }
+        orders.push_back(order);
+    }
 
-        if (itemGroup == NULL)
+    // Every configuration worth trying
+    QVector<binpack_candidate> candidates;
+    for (int order = 0; order < orders.length(); ++order)
+    {
+        binpack_candidate candidate;
+        candidate.order = order;
+        candidate.split = 0;
+
+        candidate.packer = PACKER_MAXRECTS;
+        for (int h = rbp::MaxRectsBinPack::RectBestShortSideFit; h <= rbp::MaxRectsBinPack::RectContactPointRule; ++h)
         {
-            qDebug() << "Error: itemgroup is null in scenescalecontainselected().";
-            hpglModel->mutexUnlock();
-            emit finished();
-            return;
+            candidate.heuristic = h;
+            candidates.push_back(candidate);
         }
 
-        initY += qMax(itemGroup->boundingRect().width(), itemGroup->boundingRect().height());
+        candidate.packer = PACKER_GUILLOTINE;
+        for (int h = rbp::GuillotineBinPack::RectBestAreaFit; h <= rbp::GuillotineBinPack::RectBestLongSideFit; ++h)
+        {
+            candidate.heuristic = h;
+            candidate.split = rbp::GuillotineBinPack::SplitMinimizeArea;
+            candidates.push_back(candidate);
+            candidate.split = rbp::GuillotineBinPack::SplitShorterLeftoverAxis;
+            candidates.push_back(candidate);
+        }
+        candidate.split = 0;
 
-        hpglModel->mutexUnlock();
+        candidate.packer = PACKER_SKYLINE;
+        candidate.heuristic = rbp::SkylineBinPack::LevelBottomLeft;
+        candidates.push_back(candidate);
+        candidate.heuristic = rbp::SkylineBinPack::LevelMinWasteFit;
+        candidates.push_back(candidate);
     }
 
-//    packer.Init(initX, initY, true);
-    mrPacker.Init(initX, initY);
+    // Candidates give up once stopFlag is set, and they're all waited
+    // for before returning, so none are left running on the global pool.
+    QFutureSynchronizer<void> running;
+    int started = candidates.length();
+    stopFlag.store(0);
+    for (int i = 0; i < candidates.length(); ++i)
+    {
+        running.addFuture(QtConcurrent::run(this, &ExtBinPack::pack, candidates.at(i),
+                                            orders.at(candidates.at(i).order), sizes, initX, initY));
+    }
 
-    for (int i = 0; i < hpglModel->rowCount(); ++i)
+    qint64 deadline = settings.value("binpack/deadline", SETDEF_BINPACK_DEADLINE).toInt();
+    int finishedCount = 0;
+    while (finishedCount < started)
     {
-        if (cancelFlag)
+        // Sleeps until a candidate finishes, the deadline or cancel()
+        qint64 remaining = deadline - deadlineTimer.elapsed();
+        if (remaining <= 0 || !packDone.tryAcquire(1, remaining) || cancelFlag.load())
         {
-            statusUpdate("Cancelling auto arrange.", Qt::darkRed);
-            emit finished();
-            return;
+            break;
         }
-        index = hpglModel->index(i);
-        itemGroup = NULL;
-        hpglModel->dataGroup(index, itemGroup);
-        hpglModel->mutexLock();
+        packMutex.lock();
+        binpack_result result = packResults.takeFirst();
+        packMutex.unlock();
+
+        ++finishedCount;
+        statusUpdate(candidateName(result.candidate) + ", order " + QString::number(result.candidate.order) + ": "
+                     + (result.ok ? (QString::number(result.length / 1016.0, 'f', 1) + " inches") : QString("failed"))
+                     + " in " + QString::number(result.nsecs / 1000) + " us.");
+        if (result.ok && (!bestResult.ok || result.length < bestResult.length))
+        {
+            bestResult = result;
+        }
+        emit progress((100 * finishedCount) / started);
+    }
+    stopFlag.store(1);
+    running.waitForFinished();
+
+    if (cancelFlag.load())
+    {
+        statusUpdate("Cancelling auto arrange.", Qt::darkRed);
+        emit finished();
+        return;
+    }
 
-        if (itemGroup == NULL)
+    if (!bestResult.ok)
+    {
+        emit statusUpdate("No packer finished within the deadline.", Qt::darkRed);
+        emit finished();
+        return;
+    }
+
+    hpglModel->setPanels(QVector<hpgl_panel>()); // everything is back on the roll
+    for (int i = 0; i < indexes.length(); ++i)
+    {
+        QRectF rect;
+        rect.setX(bestResult.rects.at(i).y());
+        rect.setY(bestResult.rects.at(i).x());
+        rect.setWidth(bestResult.rects.at(i).height());
+        rect.setHeight(bestResult.rects.at(i).width());
+        emit packedRect(indexes.at(i), rect);
+    }
+
+    emit statusUpdate("Finished arranging files: " + candidateName(bestResult.candidate) + " used "
+                      + QString::number(bestResult.length / 1016.0, 'f', 1) + " inches, best of "
+                      + QString::number(finishedCount) + "/" + QString::number(started)
+                      + " layouts in " + QString::number(deadlineTimer.elapsed()) + " ms.");
+    emit finished();
+}
+
+/**
+ * @brief ExtBinPack::processIncremental
+ * Leaves placed files alone and fits the rest into the space around them,
+ * so only the new files are searched and nothing on the vinyl moves.
+ */
+void ExtBinPack::processIncremental()
+{
+    QVector<QPersistentModelIndex> indexes;
+    QVector<QSizeF> sizes;
+    QVector<QRectF> occupied;
+    QVector<QPair<double, int> > pending;
+    double pad = packMargin();
+    double used = 0;
+    double extra = 0;
+
+    if (!fileSizes(hpglModel, indexes, sizes))
+    {
+        emit finished();
+        return;
+    }
+
+    hpglSnapshot job = hpglModel->snapshot();
+    if (job->files.length() != indexes.length())
+    {
+        emit finished(); // files were added or removed meanwhile
+        return;
+    }
+    for (int i = 0; i < indexes.length(); ++i)
+    {
+        const hpgl_snapshot_file & file = job->files.at(i);
+        if (!file.placed)
         {
-            qDebug() << "Error: itemgroup is null in scenescalecontainselected().";
-            hpglModel->mutexUnlock();
-            emit finished();
-            return;
+            double longest = qMax(sizes.at(i).width(), sizes.at(i).height());
+            pending.push_back(qMakePair(-longest, i));
+            extra += longest;
+            continue;
         }
 
-        QMarginsF margin;
-        double padding = settings.value("device/cutoutboxes/padding", SETDEF_DEVICE_CUTOUTBOXES_PADDING).toDouble();
-        if (settings.value("device/width/type", SETDEF_DEVICE_WDITH_TYPE).toInt() == deviceWidth_t::CM)
+        // Scene x is along the roll, packer x is across it
+        QRectF rect = file.rect;
+        occupied.push_back(QRectF(rect.y(), rect.x(), rect.height(), rect.width()).adjusted(-pad, -pad, pad, pad));
+        if (file.panel < 0)
         {
-            padding = padding * 2.54;
+            used = qMax(used, rect.right() + pad);
         }
-        padding = padding * 1016.0;
+    }
 
-        margin.setTop(padding);
-        margin.setRight(padding);
+    // New files only go on the roll, never onto a remnant panel
+    const QVector<hpgl_panel> & panels = job->panels;
+    int remnantCount = 0;
+    for (int i = 0; i < panels.length(); ++i)
+    {
+        if (panels.at(i).roll)
+        {
+            continue;
+        }
+        QRectF rect = panels.at(i).rect;
+        occupied.push_back(QRectF(rect.y(), rect.x(), rect.height(), rect.width()));
+        ++remnantCount;
+    }
 
-//        rbp::Rect thisrect = packer.Insert(itemGroup->boundingRect().marginsAdded(margin).width(),
-//                                           itemGroup->boundingRect().marginsAdded(margin).height(),
-//                                           rbp::ShelfBinPack::ShelfChoiceHeuristic::ShelfWorstAreaFit);
+    if (pending.isEmpty())
+    {
+        emit statusUpdate("No new files to arrange.");
+        emit finished();
+        return;
+    }
 
-        rbp::Rect thisrect = mrPacker.Insert(itemGroup->boundingRect().marginsAdded(margin).width(),
-                                             itemGroup->boundingRect().marginsAdded(margin).height(),
-                                             rbp::MaxRectsBinPack::FreeRectChoiceHeuristic::RectBottomLeftRule);
+    QLineF widthLine = MainWindow::get_widthLine();
+    hpglFreeSpace space(widthLine.p2().y() - widthLine.p1().y(), used + extra);
+    for (int i = 0; i < occupied.length(); ++i)
+    {
+        space.occupy(occupied.at(i));
+    }
 
+    std::stable_sort(pending.begin(), pending.end());
+    int placedCount = 0;
+    for (int i = 0; i < pending.length(); ++i)
+    {
+        int file = pending.at(i).second;
+        QRectF packed;
+        if (!space.insert(sizes.at(file).width(), sizes.at(file).height(), packed))
+        {
+            emit statusUpdate("A file is wider than the vinyl, skipping it.", Qt::darkRed);
+            continue;
+        }
         QRectF rect;
-        rect.setX(thisrect.y);
-        rect.setY(thisrect.x);
-        rect.setWidth(thisrect.height);
-        rect.setHeight(thisrect.width);
-        emit packedRect(index, rect);
-
-        hpglModel->mutexUnlock();
+        rect.setX(packed.y());
+        rect.setY(packed.x());
+        rect.setWidth(packed.height());
+        rect.setHeight(packed.width());
+        emit packedRect(indexes.at(file), rect);
+        ++placedCount;
+        emit progress((100 * (i+1)) / pending.length());
     }
 
-    emit statusUpdate("Finished arranging files.");
+    emit statusUpdate("Arranged " + QString::number(placedCount) + " new files around "
+                      + QString::number(occupied.length() - remnantCount) + " placed ones.");
     emit finished();
 }
 
-void ExtBinPack::cancel()
+/**
+ * @brief ExtBinPack::processRemnants
+ * Fills the remnant inventory before touching the roll. Files go largest
+ * first into the smallest remnant they fit, every remnant being searched
+ * at once, and whatever is left over is strip packed onto the roll. Each
+ * remnant used becomes a panel laid out past the end of the roll.
+ */
+void ExtBinPack::processRemnants()
 {
-    cancelFlag = true;
-}
-
-void ExtBinPack::statusUpdate(QString _consoleStatus)
-{
-    emit statusUpdate(_consoleStatus, Qt::black);
-}
+    QSettings settings;
+    QVector<QPersistentModelIndex> indexes;
+    QVector<QSizeF> sizes;
+    QVector<remnant_piece> pieces = hpglRemnants::load();
+    QVector<hpglFreeSpace> bins;
+    QVector<QPair<double, int> > pieceOrder, fileOrder;
+    QElapsedTimer timer;
+
+    timer.start();
+    if (pieces.isEmpty())
+    {
+        emit statusUpdate("The remnant inventory is empty.", Qt::darkRed);
+        emit finished();
+        return;
+    }
+    if (!fileSizes(hpglModel, indexes, sizes) || sizes.isEmpty())
+    {
+        emit finished();
+        return;
+    }
 
+    // Smallest remnants first, so the big ones are kept for big files
+    for (int i = 0; i < pieces.length(); ++i)
+    {
+        pieceOrder.push_back(qMakePair(hpglRemnants::area(pieces.at(i).outline), i));
+    }
+    std::stable_sort(pieceOrder.begin(), pieceOrder.end());
+    for (int i = 0; i < pieceOrder.length(); ++i)
+    {
+        bins.push_back(hpglRemnants::freeSpace(pieces.at(pieceOrder.at(i).second).outline));
+    }
 
+    for (int i = 0; i < sizes.length(); ++i)
+    {
+        fileOrder.push_back(qMakePair(-(sizes.at(i).width() * sizes.at(i).height()), i));
+    }
+    std::stable_sort(fileOrder.begin(), fileOrder.end());
 
+    QVector<int> fileBin(sizes.length(), -1);
+    QVector<QRectF> fileRects(sizes.length());
+    QVector<QRectF> placed(bins.length());
+    QVector<QSizeF> rollSizes;
+    QVector<int> rollFiles;
+    double remnantArea = 0;
 
+    for (int i = 0; i < fileOrder.length(); ++i)
+    {
+        if (cancelFlag.load())
+        {
+            statusUpdate("Cancelling auto arrange.", Qt::darkRed);
+            emit finished();
+            return;
+        }
 
+        int file = fileOrder.at(i).second;
 
+        // Nothing changes the bins until every search is back
+        QVector<QFuture<bool> > futures;
+        for (int bin = 0; bin < bins.length(); ++bin)
+        {
+            futures.push_back(QtConcurrent::run(&ExtBinPack::fitBin, &bins.at(bin), sizes.at(file), &placed[bin]));
+        }
+        int chosen = -1;
+        for (int bin = 0; bin < futures.length(); ++bin)
+        {
+            if (futures[bin].result() && chosen < 0)
+            {
+                chosen = bin;
+            }
+        }
 
+        if (chosen < 0)
+        {
+            rollFiles.push_back(file);
+            rollSizes.push_back(sizes.at(file));
+        }
+        else
+        {
+            bins[chosen].occupy(placed.at(chosen));
+            fileBin[file] = chosen;
+            fileRects[file] = placed.at(chosen);
+            remnantArea += sizes.at(file).width() * sizes.at(file).height();
+        }
+        emit progress((50 * (i+1)) / fileOrder.length());
+    }
 
+    // The rest goes on the roll
+    QLineF widthLine = MainWindow::get_widthLine();
+    hpglStripPacker stripPacker(widthLine.p2().y() - widthLine.p1().y());
+    QVector<QRectF> rollRects;
+    double rollLength = 0;
+    if (!rollSizes.isEmpty()
+            && !stripPacker.optimize(rollSizes, settings.value("binpack/strip", SETDEF_BINPACK_STRIP).toInt(),
+                                     rollRects, rollLength))
+    {
+        emit statusUpdate("A file is wider than the vinyl.", Qt::darkRed);
+        emit finished();
+        return;
+    }
+    for (int i = 0; i < rollFiles.length(); ++i)
+    {
+        fileRects[rollFiles.at(i)] = rollRects.at(i);
+    }
+    emit progress(75);
 
+    // Used remnants are laid out along the roll past its end
+    QVector<hpgl_panel> panels;
+    QVector<QPointF> binOrigin(bins.length());
+    double offset = rollLength + BINPACK_PANEL_GAP;
+    for (int bin = 0; bin < bins.length(); ++bin)
+    {
+        if (!fileBin.contains(bin))
+        {
+            continue;
+        }
+        const remnant_piece & piece = pieces.at(pieceOrder.at(bin).second);
+        QRectF bounds = piece.outline.boundingRect();
+        hpgl_panel panel;
+        panel.name = piece.name;
+        panel.roll = false;
+        panel.rect = QRectF(offset, 0, bounds.height(), bounds.width());
+        for (int i = 0; i < piece.outline.length(); ++i)
+        {
+            QPointF point = piece.outline.at(i) - bounds.topLeft();
+            panel.outline.push_back(QPointF(point.y() + offset, point.x()));
+        }
+        panels.push_back(panel);
+        binOrigin[bin] = panel.rect.topLeft();
+        offset += bounds.height() + BINPACK_PANEL_GAP;
+    }
+    hpglModel->setPanels(panels);
 
+    for (int i = 0; i < indexes.length(); ++i)
+    {
+        QPointF origin;
+        if (fileBin.at(i) >= 0)
+        {
+            origin = binOrigin.at(fileBin.at(i));
+        }
+        QRectF rect;
+        rect.setX(fileRects.at(i).y() + origin.x());
+        rect.setY(fileRects.at(i).x() + origin.y());
+        rect.setWidth(fileRects.at(i).height());
+        rect.setHeight(fileRects.at(i).width());
+        emit packedRect(indexes.at(i), rect);
+    }
+    emit progress(100);
+
+    emit statusUpdate("Arranged " + QString::number(indexes.length() - rollFiles.length()) + " files onto "
+                      + QString::number(panels.length()) + " remnants ("
+                      + QString::number(remnantArea / (1016.0 * 1016.0), 'f', 1) + " sq in), "
+                      + QString::number(rollFiles.length()) + " onto "
+                      + QString::number(rollLength / 1016.0, 'f', 1) + " inches of roll in "
+                      + QString::number(timer.elapsed()) + " ms.");
+    emit finished();
+}
 
+/**
+ * @brief ExtBinPack::fitBin
+ * Runs on a pool thread, only reading the bin.
+ */
+bool ExtBinPack::fitBin(const hpglFreeSpace * bin, QSizeF size, QRectF * placed)
+{
+    return(bin->find(size.width(), size.height(), *placed));
+}
 
+void ExtBinPack::setRemnants(bool remnants)
+{
+    remnantsFlag = remnants;
+}
 
+/**
+ * @brief ExtBinPack::rotateFiles
+ * Turns every file to its tightest bounding box before packing. The hulls
+ * are found on the thread pool, and a file keeps its answer until it or
+ * its rotation changes, so moving it around costs nothing.
+ */
+void ExtBinPack::rotateFiles()
+{
+    QSettings settings;
+    QVector<QPersistentModelIndex> indexes;
+    QVector<QTransform> transforms;
+    QVector<QFuture<double> > futures;
+    QElapsedTimer timer;
+    int turned = 0;
+
+    int mode = settings.value("binpack/rotation", SETDEF_BINPACK_ROTATION).toInt();
+    if (mode == ROTATION_NONE)
+    {
+        return;
+    }
 
+    timer.start();
+    hpglSnapshot job = hpglModel->snapshot();
+    for (int i = 0; i < job->files.length(); ++i)
+    {
+        const hpgl_snapshot_file & file = job->files.at(i);
+        QPersistentModelIndex index = file.index;
+        QTransform scene = file.transform;
+        QTransform linear(scene.m11(), scene.m12(), scene.m21(), scene.m22(), 0, 0);
 
+        double angle;
+        if (hpglModel->rotationCache(index, linear, angle))
+        {
+            continue;
+        }
 
+        // Every stroke point, without translation; the box follows the file
+        QPolygonF points;
+        for (int i2 = 0; i2 < file.geometry.length(); ++i2)
+        {
+            points += linear.map(file.geometry.at(i2));
+        }
 
+        indexes.push_back(index);
+        transforms.push_back(linear);
+        futures.push_back(QtConcurrent::run(&hpglGeometry::minimumRectAngle, points, (mode == ROTATION_WIDTH)));
+    }
 
+    for (int i = 0; i < futures.length(); ++i)
+    {
+        double angle = futures[i].result();
+        QTransform transform = transforms.at(i);
+        if (qAbs(angle) > 0.01)
+        {
+            transform = transform * QTransform().rotate(angle);
+            emit rotatedItem(indexes.at(i), transform); // blocks until the scene has it
+            ++turned;
+        }
+        hpglModel->setRotationCache(indexes.at(i), transform, 0);
+    }
 
+    qDebug() << "Bin pack rotation checked" << futures.length() << "files, turned" << turned
+             << "in" << timer.elapsed() << "ms";
+}
 
+void ExtBinPack::setIncremental(bool incremental)
+{
+    incrementalFlag = incremental;
+}
 
+/**
+ * @brief ExtBinPack::padding
+ * @return - the cutout box padding in plotter units
+ */
+double ExtBinPack::padding()
+{
+    QSettings settings;
+    double padding = settings.value("device/cutoutboxes/padding", SETDEF_DEVICE_CUTOUTBOXES_PADDING).toDouble();
+    if (settings.value("device/width/type", SETDEF_DEVICE_WDITH_TYPE).toInt() == deviceWidth_t::CM)
+    {
+        padding = padding * 2.54;
+    }
+    return(padding * 1016.0);
+}
 
+/**
+ * @brief ExtBinPack::packMargin
+ * Space packed between files. Cutout boxes already have the padding around
+ * them, and with shared edges they're packed touching so the edges can be
+ * cut once.
+ */
+double ExtBinPack::packMargin()
+{
+    QSettings settings;
+    if (settings.value("device/cutoutboxes", SETDEF_DEVICE_CUTOUTBOXES).toBool()
+            && settings.value("device/cutoutboxes/shared", SETDEF_DEVICE_CUTOUTBOXES_SHARED).toBool())
+    {
+        return 0;
+    }
+    return(padding());
+}
 
+/**
+ * @brief ExtBinPack::fileSizes
+ * Every file's bounding box, as it's turned on the vinyl, with the pack
+ * margin on the top and right.
+ */
+bool ExtBinPack::fileSizes(hpglListModel * model, QVector<QPersistentModelIndex> & indexes, QVector<QSizeF> & sizes)
+{
+    QMarginsF margin;
+    margin.setTop(packMargin());
+    margin.setRight(packMargin());
+
+    hpglSnapshot job = model->snapshot();
+    indexes.clear();
+    sizes.clear();
+    for (int i = 0; i < job->files.length(); ++i)
+    {
+        indexes.push_back(job->files.at(i).index);
+        sizes.push_back(job->files.at(i).rect.marginsAdded(margin).size());
+    }
+    return true;
+}
 
+/**
+ * @brief ExtBinPack::pack
+ * Runs one candidate on a pool thread. Packer x is across the roll.
+ * The result is queued for process() to collect, unless it stopped waiting.
+ */
+void ExtBinPack::pack(binpack_candidate candidate, QVector<int> order,
+                      QVector<QSizeF> sizes, int width, int height)
+{
+    rbp::MaxRectsBinPack mrPacker;
+    rbp::GuillotineBinPack gPacker;
+    rbp::SkylineBinPack sPacker;
+    QElapsedTimer timer;
+    binpack_result result;
+
+    timer.start();
+    result.candidate = candidate;
+    result.rects.resize(sizes.length());
+    result.length = 0;
+    result.ok = true;
+
+    switch (candidate.packer)
+    {
+    case PACKER_MAXRECTS:
+        mrPacker.Init(width, height);
+        break;
+    case PACKER_GUILLOTINE:
+        gPacker.Init(width, height);
+        break;
+    default:
+        sPacker.Init(width, height, true);
+        break;
+    }
 
+    for (int i = 0; i < order.length() && result.ok; ++i)
+    {
+        if (stopFlag.load())
+        {
+            return;
+        }
+        int file = order.at(i);
+        int w = sizes.at(file).width();
+        int h = sizes.at(file).height();
+        rbp::Rect packed;
 
+        switch (candidate.packer)
+        {
+        case PACKER_MAXRECTS:
+            packed = mrPacker.Insert(w, h, static_cast<rbp::MaxRectsBinPack::FreeRectChoiceHeuristic>(candidate.heuristic));
+            break;
+        case PACKER_GUILLOTINE:
+            packed = gPacker.Insert(w, h, true,
+                                    static_cast<rbp::GuillotineBinPack::FreeRectChoiceHeuristic>(candidate.heuristic),
+                                    static_cast<rbp::GuillotineBinPack::GuillotineSplitHeuristic>(candidate.split));
+            break;
+        default:
+            packed = sPacker.Insert(w, h, static_cast<rbp::SkylineBinPack::LevelChoiceHeuristic>(candidate.heuristic));
+            break;
+        }
 
+        if (packed.height == 0)
+        {
+            result.ok = false;
+            break;
+        }
+        result.rects[file] = QRectF(packed.x, packed.y, packed.width, packed.height);
+        result.length = qMax(result.length, (double)(packed.y + packed.height));
+    }
 
+    result.nsecs = timer.nsecsElapsed();
+    packMutex.lock();
+    packResults.push_back(result);
+    packMutex.unlock();
+    packDone.release();
+}
 
+QString ExtBinPack::candidateName(const binpack_candidate & candidate)
+{
+    return(QString(binpackPacker_names[candidate.packer]) + " " + QString::number(candidate.heuristic)
+           + (candidate.packer == PACKER_GUILLOTINE ? ("/" + QString::number(candidate.split)) : QString()));
+}
 
+void ExtBinPack::cancel()
+{
+    cancelFlag.store(1);
+    packDone.release(); // wakes process() if it's waiting on candidates
+}
 
+void ExtBinPack::statusUpdate(QString _consoleStatus)
+{
+    emit statusUpdate(_consoleStatus, Qt::black);
+}
@@ -15,10 +15,54 @@
 
 #include "settings.h"
 #include "hpgllistmodel.h"
+#include <QtConcurrent>
+#include <QFutureSynchronizer>
+#include <QSemaphore>
+#include <QMutex>
+#include <algorithm>
+
 //#include "RectangleBinPack/ShelfBinPack.h"
 #include "RectangleBinPack/MaxRectsBinPack.h"
+#include "RectangleBinPack/GuillotineBinPack.h"
+#include "RectangleBinPack/SkylineBinPack.h"
+#include "strippack.h"
+#include "geometry.h"
+#include "freespace.h"
+#include "remnants.h"
 #include "mainwindow.h"
 
+// Space left between the roll and the first remnant, and between remnants
+#define BINPACK_PANEL_GAP (2032) // 2"
+
+// Packer families raced against each other
+enum binpackPacker_t {
+    PACKER_MAXRECTS = 0,
+    PACKER_GUILLOTINE,
+    PACKER_SKYLINE,
+    PACKER_STRIP,
+    PACKER_SIZE_OF_ENUM
+};
+static const char* binpackPacker_names[] = {"MaxRects", "Guillotine", "Skyline", "Strip"};
+
+static_assert(sizeof(binpackPacker_names)/sizeof(char*) == binpackPacker_t::PACKER_SIZE_OF_ENUM
+    , "Bin pack packer names dont match");
+
+// One packer configuration over one ordering of the files
+struct binpack_candidate {
+    binpackPacker_t packer;
+    int heuristic;
+    int split;              // guillotine only
+    int order;              // index into the sort orders
+};
+
+struct binpack_result {
+    binpack_candidate candidate;
+    QVector<QRectF> rects;  // in packer coordinates, by file
+    double length;          // along the roll
+    qint64 nsecs;
+    bool ok;                // every file fit
+};
+
 namespace std {
 class ExtBinPack;
 }
@@ -30,6 +74,11 @@ class ExtBinPack : public QObject
 public:
     ExtBinPack(hpglListModel * model);
     ~ExtBinPack();
+    void setIncremental(bool incremental);
+    void setRemnants(bool remnants);
+    static bool fileSizes(hpglListModel * model, QVector<QPersistentModelIndex> & indexes, QVector<QSizeF> & sizes);
+    static double padding();
+    static double packMargin();
 
 public slots:
     void process();
@@ -40,11 +89,27 @@ signals:
     void finished();
     void statusUpdate(QString text, QColor textColor);
     void packedRect(QPersistentModelIndex index, QRectF rect);
+    void rotatedItem(QPersistentModelIndex index, QTransform transform);
 
 private:
     void statusUpdate(QString _consoleStatus);
+    void processIncremental();
+    void processRemnants();
+    void rotateFiles();
+    static bool fitBin(const hpglFreeSpace * bin, QSizeF size, QRectF * placed);
+    void pack(binpack_candidate candidate, QVector<int> order,
+              QVector<QSizeF> sizes, int width, int height);
+    static QString candidateName(const binpack_candidate & candidate);
+
     hpglListModel * hpglModel;
-    bool cancelFlag;
+    QAtomicInt cancelFlag;
+    // Candidate race
+    QAtomicInt stopFlag;                    // candidates still running give up
+    QSemaphore packDone;                    // one per result, and one on cancel()
+    QMutex packMutex;
+    QVector<binpack_result> packResults;    // finished, not yet collected
+    bool incrementalFlag;
+    bool remnantsFlag;
 };
 
 #endif // EXTBINPACK_H
@@ -0,0 +1,197 @@
+/**
+ * hpglDedup - duplicate cut removal
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "dedup.h"
+
+hpglDedup::hpglDedup(double _tolerance)
+{
+    tolerance = _tolerance;
+    stamp = 0;
+    removed = 0;
+    removedCount = 0;
+}
+
+/**
+ * @brief hpglDedup::add
+ * Trims a polyline against everything added before it, including itself.
+ * @return - what's left to cut, split wherever a piece was removed
+ */
+QVector<QPolygon> hpglDedup::add(const QPolygon & poly)
+{
+    QVector<QPolygon> pieces;
+    QPolygon current;
+
+    if (poly.count() < 2)
+    {
+        pieces.push_back(poly);
+        return(pieces);
+    }
+
+    for (int i = 1; i < poly.count(); ++i)
+    {
+        QLine segment(poly.at(i-1), poly.at(i));
+        QVector<QPair<double, double> > keep = uncovered(segment);
+
+        for (int j = 0; j < keep.length(); ++j)
+        {
+            QPoint from = segment.p1() + ((segment.p2() - segment.p1()) * keep.at(j).first);
+            QPoint to = segment.p1() + ((segment.p2() - segment.p1()) * keep.at(j).second);
+            if (!current.isEmpty() && current.last() != from)
+            {
+                pieces.push_back(current);
+                current.clear();
+            }
+            if (current.isEmpty())
+            {
+                current << from;
+            }
+            current << to;
+            insert(QLine(from, to));
+        }
+
+        if (keep.isEmpty())
+        {
+            ++removedCount;
+        }
+        if (keep.isEmpty() || keep.last().second < 1)
+        {
+            if (current.count() > 1)
+            {
+                pieces.push_back(current);
+            }
+            current.clear();
+        }
+    }
+    if (current.count() > 1)
+    {
+        pieces.push_back(current);
+    }
+    return(pieces);
+}
+
+/**
+ * @brief hpglDedup::uncovered
+ * A kept segment covers part of this one if both its ends are within the
+ * tolerance of this one's line; whatever no kept segment covers is left.
+ * @return - parameter ranges along the segment, 0 at p1 and 1 at p2
+ */
+QVector<QPair<double, double> > hpglDedup::uncovered(const QLine & segment)
+{
+    QVector<QPair<double, double> > covered, keep;
+    double dx = segment.dx();
+    double dy = segment.dy();
+    double length = qSqrt((dx * dx) + (dy * dy));
+
+    if (length <= tolerance)
+    {
+        keep.push_back(qMakePair(0.0, 1.0));
+        return(keep);
+    }
+    double ux = dx / length;
+    double uy = dy / length;
+
+    // Every cell the segment could share with a kept one
+    int pad = qCeil(tolerance);
+    int x0 = qFloor((double)(qMin(segment.x1(), segment.x2()) - pad) / DEDUP_CELL);
+    int x1 = qFloor((double)(qMax(segment.x1(), segment.x2()) + pad) / DEDUP_CELL);
+    int y0 = qFloor((double)(qMin(segment.y1(), segment.y2()) - pad) / DEDUP_CELL);
+    int y1 = qFloor((double)(qMax(segment.y1(), segment.y2()) + pad) / DEDUP_CELL);
+
+    ++stamp;
+    for (int cx = x0; cx <= x1; ++cx)
+    {
+        for (int cy = y0; cy <= y1; ++cy)
+        {
+            QHash<quint64, QVector<int> >::const_iterator cell = cells.constFind(cellKey(cx, cy));
+            if (cell == cells.constEnd())
+            {
+                continue;
+            }
+            for (int i = 0; i < cell.value().length(); ++i)
+            {
+                int id = cell.value().at(i);
+                if (visited.at(id) == stamp)
+                {
+                    continue;
+                }
+                visited[id] = stamp;
+
+                const QLine & other = kept.at(id);
+                double ax = other.x1() - segment.x1(), ay = other.y1() - segment.y1();
+                double bx = other.x2() - segment.x1(), by = other.y2() - segment.y1();
+                if (qAbs((ux * ay) - (uy * ax)) > tolerance || qAbs((ux * by) - (uy * bx)) > tolerance)
+                {
+                    continue;
+                }
+                double s0 = ((ux * ax) + (uy * ay)) / length;
+                double s1 = ((ux * bx) + (uy * by)) / length;
+                double lo = qMax(0.0, qMin(s0, s1));
+                double hi = qMin(1.0, qMax(s0, s1));
+                if ((hi - lo) * length > tolerance)
+                {
+                    covered.push_back(qMakePair(lo, hi));
+                }
+            }
+        }
+    }
+
+    // Gaps between the covered ranges
+    std::sort(covered.begin(), covered.end());
+    double position = 0;
+    for (int i = 0; i <= covered.length(); ++i)
+    {
+        double next = (i < covered.length()) ? covered.at(i).first : 1.0;
+        if ((next - position) * length > tolerance)
+        {
+            keep.push_back(qMakePair(position, next));
+        }
+        if (i < covered.length())
+        {
+            position = qMax(position, covered.at(i).second);
+        }
+    }
+
+    double kept = 0;
+    for (int i = 0; i < keep.length(); ++i)
+    {
+        kept += keep.at(i).second - keep.at(i).first;
+    }
+    removed += (1.0 - kept) * length;
+    return(keep);
+}
+
+void hpglDedup::insert(const QLine & segment)
+{
+    int id = kept.length();
+    kept.push_back(segment);
+    visited.push_back(0);
+
+    int x0 = qFloor((double)qMin(segment.x1(), segment.x2()) / DEDUP_CELL);
+    int x1 = qFloor((double)qMax(segment.x1(), segment.x2()) / DEDUP_CELL);
+    int y0 = qFloor((double)qMin(segment.y1(), segment.y2()) / DEDUP_CELL);
+    int y1 = qFloor((double)qMax(segment.y1(), segment.y2()) / DEDUP_CELL);
+    for (int cx = x0; cx <= x1; ++cx)
+    {
+        for (int cy = y0; cy <= y1; ++cy)
+        {
+            cells[cellKey(cx, cy)].push_back(id);
+        }
+    }
+}
+
+quint64 hpglDedup::cellKey(int x, int y)
+{
+    return((static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y));
+}
+
+// In plotter units
+double hpglDedup::removedLength()
+{
+    return(removed);
+}
+
+int hpglDedup::removedSegments()
+{
+    return(removedCount);
+}
@@ -0,0 +1,52 @@
+/**
+ * hpglDedup - duplicate cut removal header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLDEDUP_H
+#define HPGLDEDUP_H
+
+#include <QtCore>
+#include <QVector>
+#include <QHash>
+#include <QLine>
+#include <QPolygon>
+#include <QtMath>
+#include <algorithm>
+
+// Spatial hash cell size, in plotter units
+#define DEDUP_CELL (254) // 1/4"
+
+namespace std {
+class hpglDedup;
+}
+
+/**
+ * @brief The hpglDedup class
+ * Remembers every segment cut so far in the job, in a spatial hash, and
+ * trims new segments down to the parts that don't lie on one of them.
+ * Works in plotter units.
+ */
+class hpglDedup
+{
+public:
+    hpglDedup(double tolerance);
+
+    QVector<QPolygon> add(const QPolygon & poly);
+    double removedLength();
+    int removedSegments();
+
+private:
+    QVector<QPair<double, double> > uncovered(const QLine & segment);
+    void insert(const QLine & segment);
+    static quint64 cellKey(int x, int y);
+
+    double tolerance;
+    QHash<quint64, QVector<int> > cells;
+    QVector<QLine> kept;
+    QVector<int> visited;   // query stamp per kept segment
+    int stamp;
+    double removed;
+    int removedCount;
+};
+
+#endif // HPGLDEDUP_H
@@ -0,0 +1,349 @@
+/**
+ * hpglEncoder - plotter output encoding
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "encoder.h"
+
+hpglEncoder::hpglEncoder(deviceEncoding_t _encoding)
+{
+    encodingType = _encoding;
+    pen = QPoint(0, 0);
+}
+
+deviceEncoding_t hpglEncoder::encoding() const
+{
+    return encodingType;
+}
+
+QPoint hpglEncoder::position() const
+{
+    return pen;
+}
+
+void hpglEncoder::appendPair(QByteArray & out, int x, int y)
+{
+    out += QByteArray::number(x);
+    out += ',';
+    out += QByteArray::number(y);
+}
+
+/**
+ * @brief hpglEncoder::begin
+ * @return - job preamble, leaves the device in the encoder's coordinate mode
+ */
+QByteArray hpglEncoder::begin()
+{
+    pen = QPoint(0, 0);
+    if (encodingType == ENCODING_RELATIVE)
+    {
+        return QByteArray("IN;SP1;PR;");
+    }
+    return QByteArray("IN;SP1;");
+}
+
+/**
+ * @brief hpglEncoder::stroke
+ * Pen up to the first point, pen down through the rest.
+ * The PU is skipped if the pen is already there, which merges chained strokes.
+ * Relative deltas are taken between truncated points so they never drift.
+ */
+QByteArray hpglEncoder::stroke(const QPolygon & points)
+{
+    QByteArray retval;
+
+    if (points.isEmpty())
+    {
+        return retval;
+    }
+
+    if (encodingType == ENCODING_POLYLINE)
+    {
+        // Pen up to the start, then relative pen down deltas
+        retval += "PE7";
+        if (points.first() != pen)
+        {
+            retval += '<';
+            appendPENumber(retval, points.first().x() - pen.x());
+            appendPENumber(retval, points.first().y() - pen.y());
+        }
+        pen = points.first();
+        for (int idx = 1; idx < points.count(); idx++)
+        {
+            appendPENumber(retval, points.at(idx).x() - pen.x());
+            appendPENumber(retval, points.at(idx).y() - pen.y());
+            pen = points.at(idx);
+        }
+        retval += ';';
+        return retval;
+    }
+
+    if (points.first() != pen)
+    {
+        retval += "PU";
+        if (encodingType == ENCODING_RELATIVE)
+        {
+            appendPair(retval, points.first().x() - pen.x(), points.first().y() - pen.y());
+        }
+        else
+        {
+            appendPair(retval, points.first().x(), points.first().y());
+        }
+        retval += ';';
+    }
+    pen = points.first();
+
+    retval += "PD";
+    for (int idx = 1; idx < points.count(); idx++)
+    {
+        const QPoint & point = points.at(idx);
+        if (encodingType == ENCODING_RELATIVE)
+        {
+            appendPair(retval, point.x() - pen.x(), point.y() - pen.y());
+        }
+        else
+        {
+            appendPair(retval, point.x(), point.y());
+        }
+        if (idx < (points.count()-1))
+        {
+            retval += ',';
+        }
+        pen = point;
+    }
+    retval += ';';
+
+    return retval;
+}
+
+/**
+ * @brief hpglEncoder::seek
+ * Lifts the pen and moves it to an absolute position, used when resuming.
+ */
+QByteArray hpglEncoder::seek(const QPoint & point)
+{
+    QByteArray retval;
+
+    pen = point;
+    if (encodingType == ENCODING_POLYLINE)
+    {
+        retval += "PE7<=";
+        appendPENumber(retval, point.x());
+        appendPENumber(retval, point.y());
+        retval += ';';
+    }
+    else if (encodingType == ENCODING_RELATIVE)
+    {
+        retval += "PA;PU";
+        appendPair(retval, point.x(), point.y());
+        retval += ";PR;";
+    }
+    else
+    {
+        retval += "PU";
+        appendPair(retval, point.x(), point.y());
+        retval += ';';
+    }
+    return retval;
+}
+
+/**
+ * @brief hpglEncoder::end
+ * @return - job trailer, returns the pen home and releases it
+ */
+QByteArray hpglEncoder::end()
+{
+    pen = QPoint(0, 0);
+    if (encodingType == ENCODING_RELATIVE)
+    {
+        return QByteArray("PA;PU0,0;SP0;IN;");
+    }
+    return QByteArray("PU0,0;SP0;IN;");
+}
+
+/**
+ * @brief hpglEncoder::absoluteLength
+ * @return - bytes the stroke takes with plain absolute PU/PD output
+ */
+int hpglEncoder::absoluteLength(const QPolygon & points)
+{
+    int length = 0;
+
+    if (points.isEmpty())
+    {
+        return 0;
+    }
+    for (int idx = 0; idx < points.count(); ++idx)
+    {
+        length += QByteArray::number(points.at(idx).x()).length();
+        length += QByteArray::number(points.at(idx).y()).length();
+        length += 1; // comma between x and y
+    }
+    length += 3; // "PU" + ';'
+    length += 3; // "PD" + ';'
+    length += qMax(0, points.count() - 2); // commas between PD pairs
+    return length;
+}
+
+/**
+ * @brief hpglEncoder::appendPENumber
+ * Sign goes in the low bit, then base 32 digits least significant first.
+ * Digits are offset by 63, the last one by 95 to terminate the number.
+ */
+void hpglEncoder::appendPENumber(QByteArray & out, int value)
+{
+    quint64 number;
+
+    if (value >= 0)
+    {
+        number = static_cast<quint64>(value) * 2;
+    }
+    else
+    {
+        number = (static_cast<quint64>(-static_cast<qint64>(value)) * 2) + 1;
+    }
+
+    while (number >= 32)
+    {
+        out += static_cast<char>(63 + (number & 31));
+        number >>= 5;
+    }
+    out += static_cast<char>(95 + number);
+}
+
+bool hpglEncoder::readPENumber(const QByteArray & data, int & pos, bool sevenBit, qint64 & value)
+{
+    quint64 number = 0;
+    int shift = 0;
+
+    while (pos < data.length() && shift < 60)
+    {
+        int c = static_cast<uchar>(data.at(pos++));
+        if (sevenBit && c >= 63 && c <= 94)
+        {
+            number |= static_cast<quint64>(c - 63) << shift;
+            shift += 5;
+        }
+        else if (sevenBit && c >= 95 && c <= 126)
+        {
+            number |= static_cast<quint64>(c - 95) << shift;
+            value = (number & 1) ? -static_cast<qint64>(number >> 1) : static_cast<qint64>(number >> 1);
+            return true;
+        }
+        else if (!sevenBit && c >= 63 && c <= 126)
+        {
+            number |= static_cast<quint64>(c - 63) << shift;
+            shift += 6;
+        }
+        else if (!sevenBit && c >= 191 && c <= 254)
+        {
+            number |= static_cast<quint64>(c - 191) << shift;
+            value = (number & 1) ? -static_cast<qint64>(number >> 1) : static_cast<qint64>(number >> 1);
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief hpglEncoder::decodePE
+ * Decodes the body of a PE command (without "PE" and ';').
+ * @param pen - current pen position, updated to the final position
+ * @param strokes - each pen down run, starting from where the pen went down
+ * @return - false on malformed data
+ */
+bool hpglEncoder::decodePE(const QByteArray & data, QPointF & pen, QVector<QPolygonF> & strokes)
+{
+    bool sevenBit = false;
+    bool penUp = false;
+    bool absolute = false;
+    int fractionBits = 0;
+    QPolygonF current;
+    int pos = 0;
+
+    while (pos < data.length())
+    {
+        char c = data.at(pos);
+        qint64 x, y;
+
+        if (c == ' ' || c == '\r' || c == '\n')
+        {
+            ++pos;
+        }
+        else if (c == '7')
+        {
+            sevenBit = true;
+            ++pos;
+        }
+        else if (c == '<')
+        {
+            penUp = true;
+            ++pos;
+        }
+        else if (c == '=')
+        {
+            absolute = true;
+            ++pos;
+        }
+        else if (c == ':' || c == '>')
+        {
+            // Select pen is ignored, fractional bits scale what follows
+            qint64 flagValue;
+            ++pos;
+            if (!readPENumber(data, pos, sevenBit, flagValue))
+            {
+                return false;
+            }
+            if (c == '>')
+            {
+                fractionBits = qBound(0, static_cast<int>(flagValue), 26);
+            }
+        }
+        else
+        {
+            if (!readPENumber(data, pos, sevenBit, x) || !readPENumber(data, pos, sevenBit, y))
+            {
+                return false;
+            }
+
+            QPointF point(x, y);
+            if (fractionBits)
+            {
+                point /= static_cast<qreal>(1 << fractionBits);
+            }
+            if (!absolute)
+            {
+                point += pen;
+            }
+
+            if (penUp)
+            {
+                if (current.length() > 1)
+                {
+                    strokes.push_back(current);
+                }
+                current.clear();
+            }
+            else
+            {
+                if (current.isEmpty())
+                {
+                    current << pen;
+                }
+                current << point;
+            }
+            pen = point;
+            penUp = false;
+            absolute = false;
+        }
+    }
+
+    if (current.length() > 1)
+    {
+        strokes.push_back(current);
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+/**
+ * hpglEncoder - plotter output encoding header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLENCODER_H
+#define HPGLENCODER_H
+
+#include <QtCore>
+#include <QPolygon>
+#include <QPolygonF>
+#include <QPoint>
+#include <QByteArray>
+
+#include "settings.h"
+
+namespace std {
+class hpglEncoder;
+}
+
+/**
+ * @brief The hpglEncoder class
+ * Turns strokes in integer plotter units into HPGL bytes.
+ * Keeps track of the pen so relative output can be emitted.
+ *
+ * PE output uses 7-bit mode (base 32), so it survives 7 data bit links
+ * and never contains a ';' before the terminator.
+ */
+class hpglEncoder
+{
+public:
+    hpglEncoder(deviceEncoding_t _encoding = ENCODING_ABSOLUTE);
+
+    deviceEncoding_t encoding() const;
+    QPoint position() const;
+
+    QByteArray begin();
+    QByteArray stroke(const QPolygon & points);
+    QByteArray seek(const QPoint & point);
+    QByteArray end();
+
+    static int absoluteLength(const QPolygon & points);
+    static bool decodePE(const QByteArray & data, QPointF & pen, QVector<QPolygonF> & strokes);
+
+private:
+    void appendPair(QByteArray & out, int x, int y);
+    static void appendPENumber(QByteArray & out, int value);
+    static bool readPENumber(const QByteArray & data, int & pos, bool sevenBit, qint64 & value);
+
+    deviceEncoding_t encodingType;
+    QPoint pen;
+};
+
+#endif // HPGLENCODER_H
@@ -18,108 +18,544 @@ double ExtEta::speedTranslate(int setting_speed)
 }
 
 /**
- * @brief AncillaryThread::lenHyp
+ * @brief ExtEta::lenHyp
  * @return - the length (in mm) of the hypotenuse of the command's line segments
  */
 double ExtEta::lenHyp(const QPolygonF _poly)
 {
-    QPointF prev;
-    QPointF curr;
-    double mm = 0;
-    prev.setX(0);
-    prev.setY(0);
+    return(hpglGeometry::polylineLength(_poly) * ETA_UNITS_TO_MM);
+}
+
+/**
+ * @brief ExtEta::motionProfile
+ * Reads the motion model parameters once, for callers that time many strokes.
+ */
+eta_motion ExtEta::motionProfile()
+{
+    QSettings settings;
+    eta_motion motion;
 
-    for (int i = 0; i < _poly.length(); i++)
+    motion.cutSpeed = speedTranslate(settings.value("device/speed/cut", SETDEF_DEVICE_SPEED_CUT).toInt());
+    motion.travelSpeed = speedTranslate(settings.value("device/speed/travel", SETDEF_DEVICE_SPEED_TRAVEL).toInt());
+    motion.acceleration = settings.value("device/motion/accel", SETDEF_DEVICE_MOTION_ACCEL).toDouble();
+    motion.junctionDeviation = settings.value("device/motion/junction", SETDEF_DEVICE_MOTION_JUNCTION).toDouble();
+    motion.penDelay = settings.value("device/motion/pendelay", SETDEF_DEVICE_MOTION_PENDELAY).toDouble() / 1000.0;
+    motion.commandDelay = settings.value("device/motion/cmddelay", SETDEF_DEVICE_MOTION_CMDDELAY).toDouble() / 1000.0;
+
+    // A calibrated profile for this device corrects the hand set values
+    settings.beginGroup("device/profiles/" + profileKey());
+    if (settings.contains("cutscale"))
     {
-        qreal x, y;
-        curr = _poly.at(i);
-        x = qFabs(curr.x() - prev.x());
-        y = qFabs(curr.y() - prev.y());
-        mm += qSqrt(x*x + y*y);
-        prev.setX(curr.x());
-        prev.setY(curr.y());
+        motion.cutSpeed *= settings.value("cutscale", 1.0).toDouble();
+        motion.travelSpeed *= settings.value("travelscale", 1.0).toDouble();
+        motion.acceleration = settings.value("accel", motion.acceleration).toDouble();
+        motion.penDelay = settings.value("pendelay", motion.penDelay * 1000.0).toDouble() / 1000.0;
     }
+    settings.endGroup();
 
-    mm = mm * 0.025; // convert graphics units to mm
-    return(mm);
+    return(motion);
 }
 
-double ExtEta::plotTime(const QPolygonF _poly)
+/**
+ * @brief ExtEta::segmentTime
+ * Trapezoidal (or triangular, if there's no room to cruise) velocity profile.
+ * @return - seconds to move length mm, entering and exiting at the given speeds
+ */
+double ExtEta::segmentTime(double length, double entry, double exit, double cruise, double accel)
 {
-    double retval = 0;
-    QSettings settings;
+    double accelDist, decelDist;
+
+    if (length <= 0)
+    {
+        return 0;
+    }
+    if (accel <= 0)
+    {
+        return(length / cruise);
+    }
+
+    accelDist = ((cruise*cruise) - (entry*entry)) / (2*accel);
+    decelDist = ((cruise*cruise) - (exit*exit)) / (2*accel);
+
+    if ((accelDist + decelDist) <= length)
+    {
+        return(((cruise - entry) / accel) + ((cruise - exit) / accel)
+               + ((length - accelDist - decelDist) / cruise));
+    }
+
+    // Never reaches cruise speed
+    double peak = qSqrt(((2*accel*length) + (entry*entry) + (exit*exit)) / 2);
+    peak = qMax(peak, qMax(entry, exit));
+    return(((peak - entry) / accel) + ((peak - exit) / accel));
+}
 
-    retval = lenHyp(_poly);
+/**
+ * @brief ExtEta::pathTime
+ * Times a polyline that starts and ends at rest. Corner speeds are limited
+ * by the junction angle, then a backward and a forward pass make every
+ * segment reachable under the acceleration limit.
+ */
+double ExtEta::pathTime(const QPolygonF & _poly, double cruise, const eta_motion & motion)
+{
+    QVector<double> lengths;
+    QVector<QPointF> directions;
+    QVector<double> speeds; // speed at each junction, lengths.length()+1 entries
+    double accel = motion.acceleration;
+    double time = 0;
+
+    if (cruise <= 0)
+    {
+        return 0;
+    }
+
+    for (int i = 1; i < _poly.length(); ++i)
+    {
+        QPointF delta = (_poly.at(i) - _poly.at(i-1)) * ETA_UNITS_TO_MM;
+        double length = qSqrt((delta.x()*delta.x()) + (delta.y()*delta.y()));
+        if (length <= 0)
+        {
+            continue;
+        }
+        lengths.push_back(length);
+        directions.push_back(delta / length);
+    }
 
-    if (retval <= 0)
+    if (lengths.isEmpty())
     {
-        return(retval);
+        return 0;
     }
 
-    retval = retval / speedTranslate(settings.value("device/speed/cut", SETDEF_DEVICE_SPEED_CUT).toInt());
+    speeds.fill(cruise, lengths.length()+1);
+    speeds.first() = 0;
+    speeds.last() = 0;
 
-    return(retval);
+    // Junction speed from the deviation the corner may cut
+    for (int i = 1; i < lengths.length(); ++i)
+    {
+        double cosTheta = -((directions.at(i-1).x() * directions.at(i).x())
+                            + (directions.at(i-1).y() * directions.at(i).y()));
+        if (cosTheta > 0.999999)
+        {
+            speeds[i] = 0; // full reversal
+        }
+        else if (cosTheta > -0.999999)
+        {
+            double sinHalf = qSqrt(0.5 * (1.0 - cosTheta));
+            double junction = qSqrt((accel * motion.junctionDeviation * sinHalf) / (1.0 - sinHalf));
+            speeds[i] = qMin(cruise, junction);
+        }
+    }
+
+    if (accel > 0)
+    {
+        for (int i = lengths.length()-1; i >= 0; --i)
+        {
+            speeds[i] = qMin(speeds.at(i), qSqrt((speeds.at(i+1)*speeds.at(i+1)) + (2*accel*lengths.at(i))));
+        }
+        for (int i = 0; i < lengths.length(); ++i)
+        {
+            speeds[i+1] = qMin(speeds.at(i+1), qSqrt((speeds.at(i)*speeds.at(i)) + (2*accel*lengths.at(i))));
+        }
+    }
+
+    for (int i = 0; i < lengths.length(); ++i)
+    {
+        time += segmentTime(lengths.at(i), speeds.at(i), speeds.at(i+1), cruise, accel);
+    }
+    return(time);
+}
+
+/**
+ * @brief ExtEta::strokeTime
+ * @return - seconds to cut a pen down polyline, including pen down/up and command delays
+ */
+double ExtEta::strokeTime(const QPolygonF & _poly, const eta_motion & motion)
+{
+    return(pathTime(_poly, motion.cutSpeed, motion) + (2*motion.penDelay) + motion.commandDelay);
+}
+
+/**
+ * @brief ExtEta::travelTime
+ * @return - seconds for a pen up move, which starts and stops at rest
+ */
+double ExtEta::travelTime(const QLineF & _line, const eta_motion & motion)
+{
+    double length = _line.length() * ETA_UNITS_TO_MM;
+
+    if (length <= 0)
+    {
+        return 0;
+    }
+    return(segmentTime(length, 0, 0, motion.travelSpeed, motion.acceleration));
+}
+
+double ExtEta::plotTime(const QPolygonF _poly)
+{
+    return(strokeTime(_poly, motionProfile()));
 }
 
 double ExtEta::plotTime(const QLineF _line)
 {
-    double retval = 0;
+    return(travelTime(_line, motionProfile()));
+}
+
+/**
+ * @brief ExtEta::profileKey
+ * @return - the serial port as a single QSettings key, one profile per device
+ */
+QString ExtEta::profileKey()
+{
     QSettings settings;
+    QString key = settings.value("serial/port", SETDEF_SERIAL_PORT).toString();
 
-    retval = _line.length() * 0.025;
+    if (key.isEmpty())
+    {
+        return("default");
+    }
+    key.replace('/', '_');
+    key.replace('\\', '_');
+    return(key);
+}
 
-    if (retval <= 0)
+QString ExtEta::sessionLogDir()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/sessions";
+    QDir().mkpath(dir);
+    return(dir);
+}
+
+/**
+ * @brief ExtEta::readSession
+ * Reads the samples from one session log, if it was recorded on this device
+ * while the device (not incremental pacing) was limiting the serial port.
+ */
+bool ExtEta::readSession(const QString & path, QVector<eta_sample> & samples, double & cutSpeed)
+{
+    QFile file(path);
+    QString port;
+    bool incremental = true;
+    double travelSpeed = 0;
+
+    cutSpeed = 0;
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
-        return(retval);
+        return false;
     }
 
-    retval = retval / speedTranslate(settings.value("device/speed/travel", SETDEF_DEVICE_SPEED_TRAVEL).toInt());
+    QTextStream in(&file);
+    QVector<eta_sample> fileSamples;
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        if (line.startsWith('#'))
+        {
+            QString key = line.mid(1).section(':', 0, 0).trimmed();
+            QString value = line.section(':', 1).trimmed();
+            if (key == "port")
+            {
+                port = value;
+            }
+            else if (key == "incremental")
+            {
+                incremental = (value.toInt() != 0);
+            }
+            else if (key == "cutspeed")
+            {
+                cutSpeed = value.toDouble();
+            }
+            else if (key == "travelspeed")
+            {
+                travelSpeed = value.toDouble();
+            }
+            continue;
+        }
 
-    return(retval);
+        QStringList fields = line.split(',');
+        if (fields.length() < 6 || fields.at(5).toInt() == 0 || cutSpeed <= 0 || travelSpeed <= 0)
+        {
+            continue; // header row, or the port wasn't backed up
+        }
+        eta_sample sample;
+        sample.strokes = fields.at(0).toInt();
+        sample.cutTime = fields.at(1).toDouble() / cutSpeed;
+        sample.travelTime = fields.at(2).toDouble() / travelSpeed;
+        sample.segments = fields.at(3).toInt();
+        sample.seconds = fields.at(4).toDouble();
+        fileSamples.push_back(sample);
+    }
+
+    if (port != profileKey() || incremental)
+    {
+        return false;
+    }
+    samples += fileSamples;
+    return(!fileSamples.isEmpty());
 }
 
-void ExtEta::process()
+/**
+ * @brief ExtEta::solveLinear
+ * Gaussian elimination with partial pivoting on a small square system.
+ */
+bool ExtEta::solveLinear(QVector<double> matrix, QVector<double> rhs, QVector<double> & solution)
 {
-    double time = 0;
-    QModelIndex index;
-    QGraphicsItemGroup * itemGroup;
-    QVector<QGraphicsPolygonItem*> * items;
-    QLineF pu_line;
+    int n = rhs.length();
+
+    for (int col = 0; col < n; ++col)
+    {
+        int pivot = col;
+        for (int row = col+1; row < n; ++row)
+        {
+            if (qFabs(matrix.at((row*n)+col)) > qFabs(matrix.at((pivot*n)+col)))
+            {
+                pivot = row;
+            }
+        }
+        if (qFabs(matrix.at((pivot*n)+col)) < 1e-12)
+        {
+            return false;
+        }
+        if (pivot != col)
+        {
+            for (int k = 0; k < n; ++k)
+            {
+                qSwap(matrix[(col*n)+k], matrix[(pivot*n)+k]);
+            }
+            qSwap(rhs[col], rhs[pivot]);
+        }
+        for (int row = col+1; row < n; ++row)
+        {
+            double factor = matrix.at((row*n)+col) / matrix.at((col*n)+col);
+            for (int k = col; k < n; ++k)
+            {
+                matrix[(row*n)+k] -= factor * matrix.at((col*n)+k);
+            }
+            rhs[row] -= factor * rhs.at(col);
+        }
+    }
+
+    solution.fill(0, n);
+    for (int row = n-1; row >= 0; --row)
+    {
+        double sum = rhs.at(row);
+        for (int k = row+1; k < n; ++k)
+        {
+            sum -= matrix.at((row*n)+k) * solution.at(k);
+        }
+        solution[row] = sum / matrix.at((row*n)+row);
+    }
+    return true;
+}
+
+/**
+ * @brief ExtEta::calibrate
+ * Least squares fit of every logged session for this device to
+ * t = a*cutTime + b*travelTime + c*segments + d*strokes,
+ * then turned back into speed corrections, acceleration and pen delay.
+ * @return - false if there isn't enough usable data
+ */
+bool ExtEta::calibrate(QString & report, eta_calibration & fitted)
+{
+    QVector<eta_sample> samples;
+    QVector<double> normal(16, 0), rhs(4, 0), fit;
+    QDir dir(sessionLogDir());
+    QStringList logs = dir.entryList(QStringList() << "*.csv", QDir::Files, QDir::Name);
+    double cutSpeedSum = 0;
+    int sessions = 0;
+
+    for (int i = 0; i < logs.length(); ++i)
+    {
+        double cutSpeed;
+        if (readSession(dir.filePath(logs.at(i)), samples, cutSpeed))
+        {
+            cutSpeedSum += cutSpeed;
+            ++sessions;
+        }
+    }
+
+    if (samples.length() < 8)
+    {
+        report = "Not enough session data for " + profileKey()
+                + ". Plot with flow control and incremental output off to record some.";
+        return false;
+    }
+
+    for (int i = 0; i < samples.length(); ++i)
+    {
+        const eta_sample & sample = samples.at(i);
+        double row[4] = {sample.cutTime, sample.travelTime, (double)sample.segments, (double)sample.strokes};
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                normal[(r*4)+c] += row[r] * row[c];
+            }
+            rhs[r] += row[r] * sample.seconds;
+        }
+    }
+
+    if (!solveLinear(normal, rhs, fit) || fit.at(0) <= 0 || fit.at(1) <= 0)
+    {
+        report = "Session data for " + profileKey() + " doesn't fit the motion model.";
+        return false;
+    }
 
-    pu_line.setP1(QPointF(0, 0));
+    double residual = 0;
+    for (int i = 0; i < samples.length(); ++i)
+    {
+        const eta_sample & sample = samples.at(i);
+        double error = (fit.at(0)*sample.cutTime) + (fit.at(1)*sample.travelTime)
+                + (fit.at(2)*sample.segments) + (fit.at(3)*sample.strokes) - sample.seconds;
+        residual += error*error;
+    }
+    residual = qSqrt(residual / samples.length());
 
-    for (int i = 0; i < hpglModel->rowCount(); ++i)
+    // Per segment overhead is roughly speed/accel for a segment that stops
+    eta_motion motion = motionProfile();
+    fitted.cutScale = 1.0 / fit.at(0);
+    fitted.travelScale = 1.0 / fit.at(1);
+    fitted.acceleration = motion.acceleration;
+    if (fit.at(2) > 0)
     {
-        index = hpglModel->index(i);
-        itemGroup = NULL;
-        items = NULL;
-        hpglModel->dataItemsGroup(index, itemGroup, items);
-        hpglModel->mutexLock();
+        fitted.acceleration = ((cutSpeedSum / sessions) * fitted.cutScale) / fit.at(2);
+    }
+    fitted.penDelay = qMax(0.0, (fit.at(3) - motion.commandDelay) / 2.0);
+
+    report = "Fitted " + QString::number(samples.length()) + " samples from "
+            + QString::number(sessions) + " sessions (rms error "
+            + QString::number(residual*1000.0, 'f', 1) + " ms):\n"
+            + "cut speed x" + QString::number(fitted.cutScale, 'f', 3)
+            + ", travel speed x" + QString::number(fitted.travelScale, 'f', 3)
+            + ", acceleration " + QString::number(fitted.acceleration, 'f', 0) + " mm/s^2"
+            + ", pen delay " + QString::number(fitted.penDelay*1000.0, 'f', 1) + " ms";
+    return true;
+}
+
+/**
+ * @brief ExtEta::saveProfile
+ * Stores a calibration for the current device.
+ * @param fitted - from calibrate()
+ */
+void ExtEta::saveProfile(const eta_calibration & fitted)
+{
+    QSettings settings;
+    settings.beginGroup("device/profiles/" + profileKey());
+    settings.setValue("cutscale", fitted.cutScale);
+    settings.setValue("travelscale", fitted.travelScale);
+    settings.setValue("accel", fitted.acceleration);
+    settings.setValue("pendelay", fitted.penDelay * 1000.0);
+    settings.endGroup();
+}
 
-        if (itemGroup == NULL)
+/**
+ * @brief ExtEta::fileTime
+ * Plot time of one file on its own, in file coordinates.
+ * @param first - set to where the first stroke starts
+ * @param last - set to where the last stroke ends
+ */
+double ExtEta::fileTime(const hpgl_snapshot_file & file, const eta_motion & motion,
+                        QPointF & first, QPointF & last)
+{
+    double time = 0;
+    bool started = false;
+
+    for (int i = 0; i <= file.geometry.length(); ++i)
+    {
+        // The cutout box is cut last
+        const QPolygonF & poly = (i < file.geometry.length()) ? file.geometry.at(i) : file.cutout_box;
+        if (poly.isEmpty())
         {
-            qDebug() << "Error: itemgroup is null in process().";
-            return;
+            continue;
         }
-        if (items == NULL)
+        if (started)
         {
-            qDebug() << "Error: items is null in process().";
-            return;
+            time += travelTime(QLineF(last, poly.first()), motion);
         }
+        else
+        {
+            first = poly.first();
+            started = true;
+        }
+        time += strokeTime(poly, motion);
+        last = poly.last();
+    }
+    return(time);
+}
+
+/**
+ * @brief ExtEta::cachedTime
+ * Sums the cached file times plus the travel between files, which is all
+ * that moving or reordering files changes. Cheap enough for every scene
+ * change, on the scene's thread.
+ * @return - false if any file needs process() first
+ */
+bool ExtEta::cachedTime(hpglListModel * model, const eta_motion & motion, double & time)
+{
+    QVector<hpgl_eta_cache> caches;
+    QPointF pen(0, 0);
 
-        for (int i2 = 0; i2 < items->length(); ++i2)
+    time = 0;
+    if (!model->etaCaches(caches))
+    {
+        return false;
+    }
+    for (int i = 0; i < caches.length(); ++i)
+    {
+        if (caches.at(i).time <= 0)
         {
-            QPolygonF poly = items->at(i2)->polygon();
-            pu_line.setP2(itemGroup->mapToScene(poly.first()));
-//            qDebug() << pu_line;
-            time += plotTime(pu_line);
-            time += plotTime(poly);
-//            qDebug() << "File: " << i << ", Object: " << i2 << ", time: " << time;
-            pu_line.setP1(itemGroup->mapToScene(poly.last()));
+            continue; // no strokes
         }
-        hpglModel->mutexUnlock();
-        emit progress((int)(100 * ((qreal)i / (hpglModel->rowCount()-1))));
+        time += travelTime(QLineF(pen, caches.at(i).first), motion);
+        time += caches.at(i).time;
+        pen = caches.at(i).last;
     }
+    return true;
+}
+
+/**
+ * @brief ExtEta::process
+ * Refreshes the plot time of files that changed, then reports the job total.
+ * The total is summed over a snapshot where every file was already cached.
+ */
+void ExtEta::process()
+{
+    double time;
+    bool refreshed;
+    eta_motion motion = motionProfile();
+
+    do
+    {
+        hpglSnapshot job = hpglModel->snapshot();
+        QPointF pen(0, 0);
+
+        time = 0;
+        refreshed = false;
+        for (int i = 0; i < job->files.length(); ++i)
+        {
+            const hpgl_snapshot_file & file = job->files.at(i);
+            double fileTime;
+            QPointF first, last;
+
+            if (!file.index.isValid())
+            {
+                continue;
+            }
+            if (!hpglModel->etaCache(file.index, fileTime, first, last))
+            {
+                fileTime = ExtEta::fileTime(file, motion, first, last);
+                hpglModel->setEtaCache(file.index, fileTime, first, last);
+                refreshed = true;
+                emit progress((int)(100 * ((qreal)i / qMax(1, job->files.length()-1))));
+            }
+            if (fileTime <= 0)
+            {
+                continue; // no strokes
+            }
+            time += travelTime(QLineF(pen, file.transform.map(first)), motion);
+            time += fileTime;
+            pen = file.transform.map(last);
+        }
+    } while (refreshed); // a file may have changed while we were busy
+
     emit finished(time);
 }
 
@@ -17,6 +17,46 @@
 
 #include "settings.h"
 #include "hpgllistmodel.h"
+#include "geometry.h"
+
+// Graphics units (1/1016") to mm
+#define ETA_UNITS_TO_MM (0.025)
+
+/**
+ * Motion parameters for the trapezoidal velocity model.
+ * Speeds in mm/s, acceleration in mm/s^2, delays in seconds.
+ */
+struct eta_motion {
+    double cutSpeed;
+    double travelSpeed;
+    double acceleration;
+    double junctionDeviation;   // mm, limits speed through corners
+    double penDelay;            // per pen up or pen down
+    double commandDelay;        // per stroke sent
+};
+
+/**
+ * A device profile fitted to recorded sessions. The scales multiply the
+ * nominal speeds from the settings, the rest replace the hand set values.
+ */
+struct eta_calibration {
+    double cutScale;
+    double travelScale;
+    double acceleration;        // mm/s^2
+    double penDelay;            // seconds, per pen up or pen down
+};
+
+/**
+ * A row from a recorded plot session: strokes the serial port took in one go,
+ * and how long the device took to make room for them.
+ */
+struct eta_sample {
+    int strokes;
+    double cutTime;     // cut length over the nominal cut speed
+    double travelTime;  // travel length over the nominal travel speed
+    int segments;       // pen down segments
+    double seconds;     // measured
+};
 
 namespace std {
 class ExtEta;
@@ -33,9 +73,18 @@ public:
     ExtEta(hpglListModel * model);
     ~ExtEta();
     static double speedTranslate(int setting_speed);
+    static eta_motion motionProfile();
     static double plotTime(const QLineF _line);
     static double plotTime(const QPolygonF _poly);
+    static double travelTime(const QLineF & _line, const eta_motion & motion);
+    static double strokeTime(const QPolygonF & _poly, const eta_motion & motion);
     static double lenHyp(const QPolygonF _poly);
+    static bool cachedTime(hpglListModel * model, const eta_motion & motion, double & time);
+    // Calibration
+    static QString profileKey();
+    static QString sessionLogDir();
+    static bool calibrate(QString & report, eta_calibration & fitted);
+    static void saveProfile(const eta_calibration & fitted);
 
 public slots:
     void process();
@@ -47,6 +96,12 @@ signals:
 
 private:
     void statusUpdate(QString _consoleStatus);
+    static double segmentTime(double length, double entry, double exit, double cruise, double accel);
+    static double pathTime(const QPolygonF & _poly, double cruise, const eta_motion & motion);
+    static double fileTime(const hpgl_snapshot_file & file, const eta_motion & motion,
+                           QPointF & first, QPointF & last);
+    static bool readSession(const QString & path, QVector<eta_sample> & samples, double & cutSpeed);
+    static bool solveLinear(QVector<double> matrix, QVector<double> rhs, QVector<double> & solution);
 
     hpglListModel * hpglModel;
 };
@@ -0,0 +1,128 @@
+/**
+ * hpglFreeSpace - free space in an existing layout
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "freespace.h"
+
+hpglFreeSpace::hpglFreeSpace(double width, double length)
+{
+    freeRects.push_back(QRectF(0, 0, width, length));
+}
+
+/**
+ * @brief hpglFreeSpace::occupy
+ * Splits every free rectangle the used one overlaps into the (up to four)
+ * maximal pieces around it.
+ */
+void hpglFreeSpace::occupy(const QRectF & used)
+{
+    int count = freeRects.length();
+
+    for (int i = 0; i < count; ++i)
+    {
+        QRectF free = freeRects.at(i);
+        if (!free.intersects(used))
+        {
+            continue;
+        }
+
+        if (used.left() > free.left())
+        {
+            freeRects.push_back(QRectF(free.left(), free.top(), used.left() - free.left(), free.height()));
+        }
+        if (used.right() < free.right())
+        {
+            freeRects.push_back(QRectF(used.right(), free.top(), free.right() - used.right(), free.height()));
+        }
+        if (used.top() > free.top())
+        {
+            freeRects.push_back(QRectF(free.left(), free.top(), free.width(), used.top() - free.top()));
+        }
+        if (used.bottom() < free.bottom())
+        {
+            freeRects.push_back(QRectF(free.left(), used.bottom(), free.width(), free.bottom() - used.bottom()));
+        }
+
+        freeRects.remove(i);
+        --i;
+        --count;
+    }
+    prune();
+}
+
+/**
+ * @brief hpglFreeSpace::insert
+ * Places a rectangle where find() would, and takes the space it covers.
+ * @param placed - set to where it went
+ */
+bool hpglFreeSpace::insert(double width, double height, QRectF & placed)
+{
+    if (!find(width, height, placed))
+    {
+        return false;
+    }
+    occupy(placed);
+    return true;
+}
+
+/**
+ * @brief hpglFreeSpace::find
+ * Bottom-left: the free spot nearest the start of the roll, then nearest
+ * the edge, either way round. Nothing is taken, so several threads may
+ * search the same space at once.
+ * @param placed - set to where it would go
+ */
+bool hpglFreeSpace::find(double width, double height, QRectF & placed) const
+{
+    double bestTop = 0;
+    bool found = false;
+
+    for (int i = 0; i < freeRects.length(); ++i)
+    {
+        const QRectF & free = freeRects.at(i);
+        for (int turn = 0; turn < 2; ++turn)
+        {
+            double w = turn ? height : width;
+            double h = turn ? width : height;
+            if (w > free.width() || h > free.height())
+            {
+                continue;
+            }
+            double top = free.top() + h;
+            if (!found || top < bestTop || (top == bestTop && free.left() < placed.left()))
+            {
+                placed = QRectF(free.left(), free.top(), w, h);
+                bestTop = top;
+                found = true;
+            }
+        }
+    }
+    return(found);
+}
+
+int hpglFreeSpace::freeCount()
+{
+    return(freeRects.length());
+}
+
+// Drops free rectangles inside other ones
+void hpglFreeSpace::prune()
+{
+    for (int i = 0; i < freeRects.length(); ++i)
+    {
+        for (int j = i+1; j < freeRects.length(); ++j)
+        {
+            if (freeRects.at(j).contains(freeRects.at(i)))
+            {
+                freeRects.remove(i);
+                --i;
+                break;
+            }
+            if (freeRects.at(i).contains(freeRects.at(j)))
+            {
+                freeRects.remove(j);
+                --j;
+            }
+        }
+    }
+}
@@ -0,0 +1,38 @@
+/**
+ * hpglFreeSpace - free space in an existing layout header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLFREESPACE_H
+#define HPGLFREESPACE_H
+
+#include <QtCore>
+#include <QVector>
+#include <QRectF>
+
+namespace std {
+class hpglFreeSpace;
+}
+
+/**
+ * @brief The hpglFreeSpace class
+ * Maximal free rectangles around rectangles that are already placed, so new
+ * ones can be fitted in without moving anything. Same axes as the packers:
+ * x is across the roll, y along it.
+ */
+class hpglFreeSpace
+{
+public:
+    hpglFreeSpace(double width, double length);
+
+    void occupy(const QRectF & used);
+    bool insert(double width, double height, QRectF & placed);
+    bool find(double width, double height, QRectF & placed) const;
+    int freeCount();
+
+private:
+    void prune();
+
+    QVector<QRectF> freeRects;
+};
+
+#endif // HPGLFREESPACE_H
@@ -0,0 +1,605 @@
+/**
+ * hpglGeometry - bulk geometry kernels
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "geometry.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The AVX kernel is compiled for that target alone and picked at runtime.
+// It only needs AVX: the length kernel is all double precision arithmetic,
+// and AVX2 adds integer and gather instructions it has no use for, so
+// dispatching on AVX2 would only leave AVX-only CPUs on the SSE2 path.
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GEOMETRY_AVX_DISPATCH
+#include <immintrin.h>
+#endif
+
+// The SIMD paths read and write Qt's point arrays directly
+static_assert(sizeof(QPointF) == 2*sizeof(double), "QPointF is not two doubles");
+static_assert(sizeof(QPoint) == 2*sizeof(int), "QPoint is not two ints");
+
+/**
+ * @brief hpglGeometry::mapToDevice
+ * Applies one transform to a whole polygon and truncates to plotter units,
+ * the same as static_cast<int>(transform.map(point)) for every point.
+ * @return - false if any mapped point is negative (out of bounds)
+ */
+bool hpglGeometry::mapToDevice(const QTransform & transform, const QPolygonF & poly, QPolygon & points)
+{
+#if defined(__SSE2__)
+    if (transform.type() == QTransform::TxProject)
+    {
+        return mapToDeviceScalar(transform, poly, points);
+    }
+
+    points.resize(poly.count());
+
+    const double * src = reinterpret_cast<const double *>(poly.constData());
+    int * dst = reinterpret_cast<int *>(points.data());
+    const int count = poly.count();
+
+    // x' = m11*x + m21*y + dx, y' = m12*x + m22*y + dy
+    const __m128d colX = _mm_set_pd(transform.m12(), transform.m11());
+    const __m128d colY = _mm_set_pd(transform.m22(), transform.m21());
+    const __m128d trans = _mm_set_pd(transform.dy(), transform.dx());
+    const __m128d zero = _mm_setzero_pd();
+    int negative = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        __m128d p = _mm_loadu_pd(src + (2*i));
+        __m128d r = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(p, p), colX),
+                                          _mm_mul_pd(_mm_unpackhi_pd(p, p), colY)),
+                               trans);
+        negative |= _mm_movemask_pd(_mm_cmplt_pd(r, zero));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + (2*i)), _mm_cvttpd_epi32(r));
+    }
+
+    return(negative == 0);
+#else
+    return mapToDeviceScalar(transform, poly, points);
+#endif
+}
+
+/**
+ * @brief hpglGeometry::mapToDeviceScalar
+ * Reference implementation of mapToDevice().
+ */
+bool hpglGeometry::mapToDeviceScalar(const QTransform & transform, const QPolygonF & poly, QPolygon & points)
+{
+    bool inBounds = true;
+
+    points.resize(poly.count());
+    for (int i = 0; i < poly.count(); ++i)
+    {
+        QPointF point = transform.map(poly.at(i));
+        if (point.x() < 0 || point.y() < 0)
+        {
+            inBounds = false;
+        }
+        points[i] = QPoint(static_cast<int>(point.x()), static_cast<int>(point.y()));
+    }
+    return inBounds;
+}
+
+/**
+ * @brief hpglGeometry::polylineLength
+ * Sum of the segment lengths, in the polygon's own units.
+ */
+double hpglGeometry::polylineLength(const QPolygonF & poly)
+{
+    if (poly.count() < 2)
+    {
+        return 0;
+    }
+    const double * src = reinterpret_cast<const double *>(poly.constData());
+#if defined(GEOMETRY_AVX_DISPATCH)
+    if (hasAVX())
+    {
+        return polylineLengthAVX(src, poly.count());
+    }
+#endif
+#if defined(__SSE2__)
+    return polylineLengthSSE2(src, poly.count());
+#else
+    Q_UNUSED(src);
+    return polylineLengthScalar(poly);
+#endif
+}
+
+/**
+ * @brief hpglGeometry::polylineLengthScalar
+ * Reference implementation of polylineLength(). The SIMD paths add in a
+ * different order, so they match it to rounding rather than bit for bit.
+ */
+double hpglGeometry::polylineLengthScalar(const QPolygonF & poly)
+{
+    double length = 0;
+
+    for (int i = 1; i < poly.count(); ++i)
+    {
+        double dx = poly.at(i).x() - poly.at(i-1).x();
+        double dy = poly.at(i).y() - poly.at(i-1).y();
+        length += qSqrt((dx*dx) + (dy*dy));
+    }
+    return(length);
+}
+
+/**
+ * @brief hpglGeometry::clipPolyline
+ * Cuts a polyline to a rectangle, one piece for each run inside it.
+ */
+QVector<QPolygonF> hpglGeometry::clipPolyline(const QPolygonF & poly, const QRectF & rect)
+{
+    QVector<QPolygonF> pieces;
+    QPolygonF current;
+
+    if (poly.count() == 1)
+    {
+        if (rect.contains(poly.first()))
+        {
+            pieces.push_back(poly);
+        }
+        return(pieces);
+    }
+
+    for (int i = 1; i < poly.count(); ++i)
+    {
+        const QPointF & a = poly.at(i-1);
+        const QPointF & b = poly.at(i);
+        double t0, t1;
+
+        if (!clipSegment(a, b, rect, t0, t1))
+        {
+            if (current.count() > 1)
+            {
+                pieces.push_back(current);
+            }
+            current.clear();
+            continue;
+        }
+
+        QPointF start = (t0 > 0) ? (a + ((b - a) * t0)) : a;
+        QPointF end = (t1 < 1) ? (a + ((b - a) * t1)) : b;
+        if (!current.isEmpty() && current.last() != start)
+        {
+            pieces.push_back(current);
+            current.clear();
+        }
+        if (current.isEmpty())
+        {
+            current << start;
+        }
+        current << end;
+    }
+    if (current.count() > 1)
+    {
+        pieces.push_back(current);
+    }
+    return(pieces);
+}
+
+/**
+ * @brief hpglGeometry::clipSegment
+ * Liang-Barsky: the part of a to b inside rect runs from t0 to t1.
+ * @return - false if none of it is inside
+ */
+bool hpglGeometry::clipSegment(const QPointF & a, const QPointF & b, const QRectF & rect,
+                               double & t0, double & t1)
+{
+    double dx = b.x() - a.x();
+    double dy = b.y() - a.y();
+    double p[4] = {-dx, dx, -dy, dy};
+    double q[4] = {a.x() - rect.left(), rect.right() - a.x(), a.y() - rect.top(), rect.bottom() - a.y()};
+
+    t0 = 0;
+    t1 = 1;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        double t = q[i] / p[i];
+        if (p[i] < 0)
+        {
+            t0 = qMax(t0, t);
+        }
+        else
+        {
+            t1 = qMin(t1, t);
+        }
+        if (t0 > t1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Cross product of (a - o) and (b - o), positive for a left turn
+static inline double cross(const QPointF & o, const QPointF & a, const QPointF & b)
+{
+    return ((a.x() - o.x()) * (b.y() - o.y())) - ((a.y() - o.y()) * (b.x() - o.x()));
+}
+
+static inline double dot(const QPointF & a, const QPointF & b)
+{
+    return (a.x() * b.x()) + (a.y() * b.y());
+}
+
+static inline bool pointLess(const QPointF & a, const QPointF & b)
+{
+    return (a.x() < b.x()) || (a.x() == b.x() && a.y() < b.y());
+}
+
+/**
+ * @brief hpglGeometry::convexHull
+ * Andrew's monotone chain, O(n log n).
+ * @return - the hull counter-clockwise, without repeating the first point
+ */
+QPolygonF hpglGeometry::convexHull(QPolygonF points)
+{
+    QPolygonF hull;
+    int n = points.count();
+
+    if (n < 3)
+    {
+        return(points);
+    }
+    std::sort(points.begin(), points.end(), pointLess);
+
+    hull.resize(2*n);
+    int k = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        while (k >= 2 && cross(hull.at(k-2), hull.at(k-1), points.at(i)) <= 0)
+        {
+            --k;
+        }
+        hull[k++] = points.at(i);
+    }
+    for (int i = n-2, lower = k+1; i >= 0; --i)
+    {
+        while (k >= lower && cross(hull.at(k-2), hull.at(k-1), points.at(i)) <= 0)
+        {
+            --k;
+        }
+        hull[k++] = points.at(i);
+    }
+    hull.resize(k-1);
+    return(hull);
+}
+
+/**
+ * @brief hpglGeometry::minimumRectAngle
+ * Rotating calipers over the convex hull: the smallest enclosing rectangle
+ * has a side on a hull edge, and the extreme points for each edge only move
+ * forward, so every edge is tried in O(n) after the hull.
+ * @param minimumWidth - minimise the narrow side instead of the area
+ * @return - degrees to rotate the points by to line that rectangle up with
+ * the axes, within +/-45
+ */
+double hpglGeometry::minimumRectAngle(QPolygonF points, bool minimumWidth)
+{
+    QPolygonF hull = convexHull(points);
+    int n = hull.count();
+    double bestScore = -1;
+    double bestAngle = 0;
+
+    if (n < 3)
+    {
+        return 0;
+    }
+
+    int right = 0, top = 0, left = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        QPointF edge = hull.at((i+1) % n) - hull.at(i);
+        double length = qSqrt((edge.x() * edge.x()) + (edge.y() * edge.y()));
+        if (length == 0)
+        {
+            continue;
+        }
+        QPointF u = edge / length;
+        QPointF v(-u.y(), u.x()); // into the hull
+
+        if (right < i)
+        {
+            right = i;
+        }
+        while (dot(u, hull.at((right+1) % n)) > dot(u, hull.at(right % n)))
+        {
+            ++right;
+        }
+        if (top < right)
+        {
+            top = right;
+        }
+        while (dot(v, hull.at((top+1) % n)) > dot(v, hull.at(top % n)))
+        {
+            ++top;
+        }
+        if (left < top)
+        {
+            left = top;
+        }
+        while (dot(u, hull.at((left+1) % n)) < dot(u, hull.at(left % n)))
+        {
+            ++left;
+        }
+
+        double width = dot(u, hull.at(right % n)) - dot(u, hull.at(left % n));
+        double height = dot(v, hull.at(top % n)) - dot(v, hull.at(i));
+
+        double score = minimumWidth ? qMin(width, height) : (width * height);
+        if (bestScore < 0 || score < bestScore)
+        {
+            bestScore = score;
+            bestAngle = -qRadiansToDegrees(qAtan2(u.y(), u.x()));
+        }
+    }
+
+    // A rectangle is the same every quarter turn, so turn as little as possible
+    while (bestAngle > 45)
+    {
+        bestAngle -= 90;
+    }
+    while (bestAngle <= -45)
+    {
+        bestAngle += 90;
+    }
+    return(bestAngle);
+}
+
+/**
+ * @brief hpglGeometry::mergeAxisSegments
+ * Joins horizontal and vertical segments that lie on the same line and
+ * overlap or touch, so an edge shared by two shapes is only cut once.
+ * Other segments pass through unchanged.
+ * @param tolerance - plotter units two lines or two ends may be apart
+ */
+QVector<QLine> hpglGeometry::mergeAxisSegments(const QVector<QLine> & segments, int tolerance)
+{
+    QVector<QLine> horizontal, vertical, merged;
+
+    // Runs are kept with p1 at the low end
+    for (int i = 0; i < segments.length(); ++i)
+    {
+        const QLine & line = segments.at(i);
+        if (line.p1() == line.p2())
+        {
+            continue;
+        }
+        if (qAbs(line.dy()) <= tolerance)
+        {
+            horizontal.push_back(QLine(qMin(line.x1(), line.x2()), line.y1(), qMax(line.x1(), line.x2()), line.y1()));
+        }
+        else if (qAbs(line.dx()) <= tolerance)
+        {
+            vertical.push_back(QLine(line.x1(), qMin(line.y1(), line.y2()), line.x1(), qMax(line.y1(), line.y2())));
+        }
+        else
+        {
+            merged.push_back(line);
+        }
+    }
+
+    mergeRuns(horizontal, tolerance, false, merged);
+    mergeRuns(vertical, tolerance, true, merged);
+    return(merged);
+}
+
+/**
+ * @brief hpglGeometry::mergeRuns
+ * Sorted sweep: by the line they're on, then along it.
+ */
+void hpglGeometry::mergeRuns(QVector<QLine> & runs, int tolerance, bool vertical, QVector<QLine> & merged)
+{
+    // (across, along) for each run
+    auto across = [vertical](const QLine & line) { return vertical ? line.x1() : line.y1(); };
+    auto start = [vertical](const QLine & line) { return vertical ? line.y1() : line.x1(); };
+    auto end = [vertical](const QLine & line) { return vertical ? line.y2() : line.x2(); };
+
+    std::sort(runs.begin(), runs.end(), [&](const QLine & a, const QLine & b) {
+        return (across(a) < across(b)) || (across(a) == across(b) && start(a) < start(b));
+    });
+
+    int i = 0;
+    while (i < runs.length())
+    {
+        // Every run within tolerance of the first one's line
+        int lineStart = i;
+        int position = across(runs.at(i));
+        while (i < runs.length() && (across(runs.at(i)) - position) <= tolerance)
+        {
+            ++i;
+        }
+        QVector<QLine> line = runs.mid(lineStart, i - lineStart);
+        std::sort(line.begin(), line.end(), [&](const QLine & a, const QLine & b) { return start(a) < start(b); });
+
+        int low = start(line.first());
+        int high = end(line.first());
+        for (int j = 1; j <= line.length(); ++j)
+        {
+            if (j < line.length() && start(line.at(j)) <= (high + tolerance))
+            {
+                high = qMax(high, end(line.at(j)));
+                continue;
+            }
+            merged.push_back(vertical ? QLine(position, low, position, high) : QLine(low, position, high, position));
+            if (j < line.length())
+            {
+                low = start(line.at(j));
+                high = end(line.at(j));
+            }
+        }
+    }
+}
+
+/**
+ * @brief hpglGeometry::chainSegments
+ * Orders segments nearest end first from a starting point, joining them
+ * into one polyline wherever one ends where the next begins.
+ */
+QVector<QPolygon> hpglGeometry::chainSegments(const QVector<QLine> & segments, QPoint start)
+{
+    QVector<QPolygon> chains;
+    QVector<bool> used(segments.length(), false);
+    QPolygon chain;
+    QPoint position = start;
+
+    for (int n = 0; n < segments.length(); ++n)
+    {
+        int best = -1;
+        int bestDistance = 0;
+        bool reversed = false;
+        for (int j = 0; j < segments.length(); ++j)
+        {
+            if (used.at(j))
+            {
+                continue;
+            }
+            int d1 = (segments.at(j).p1() - position).manhattanLength();
+            int d2 = (segments.at(j).p2() - position).manhattanLength();
+            if (best < 0 || qMin(d1, d2) < bestDistance)
+            {
+                best = j;
+                bestDistance = qMin(d1, d2);
+                reversed = (d2 < d1);
+            }
+        }
+        used[best] = true;
+
+        QPoint from = reversed ? segments.at(best).p2() : segments.at(best).p1();
+        QPoint to = reversed ? segments.at(best).p1() : segments.at(best).p2();
+        if (!chain.isEmpty() && bestDistance != 0)
+        {
+            chains.push_back(chain);
+            chain.clear();
+        }
+        if (chain.isEmpty())
+        {
+            chain << from;
+        }
+        chain << to;
+        position = to;
+    }
+    if (!chain.isEmpty())
+    {
+        chains.push_back(chain);
+    }
+    return(chains);
+}
+
+/**
+ * @brief hpglGeometry::polylineLengthSSE2
+ * Two segments per iteration, one per lane.
+ * @param src - count points as interleaved x, y
+ */
+double hpglGeometry::polylineLengthSSE2(const double * src, int count)
+{
+#if defined(__SSE2__)
+    __m128d sum = _mm_setzero_pd();
+    __m128d p0 = _mm_loadu_pd(src);
+    int i = 1;
+
+    for (; i+1 < count; i += 2)
+    {
+        __m128d p1 = _mm_loadu_pd(src + (2*i));
+        __m128d p2 = _mm_loadu_pd(src + (2*i) + 2);
+        __m128d d0 = _mm_sub_pd(p1, p0);
+        __m128d d1 = _mm_sub_pd(p2, p1);
+        d0 = _mm_mul_pd(d0, d0);
+        d1 = _mm_mul_pd(d1, d1);
+        // lanes: dx0^2 + dy0^2, dx1^2 + dy1^2
+        __m128d sq = _mm_add_pd(_mm_unpacklo_pd(d0, d1), _mm_unpackhi_pd(d0, d1));
+        sum = _mm_add_pd(sum, _mm_sqrt_pd(sq));
+        p0 = p2;
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+    double length = lanes[0] + lanes[1];
+
+    if (i < count)
+    {
+        double dx = src[2*i] - src[(2*i)-2];
+        double dy = src[(2*i)+1] - src[(2*i)-1];
+        length += qSqrt((dx*dx) + (dy*dy));
+    }
+    return(length);
+#else
+    Q_UNUSED(src);
+    Q_UNUSED(count);
+    return 0;
+#endif
+}
+
+#if defined(GEOMETRY_AVX_DISPATCH)
+/**
+ * @brief hpglGeometry::polylineLengthAVX
+ * Four segments per iteration.
+ */
+__attribute__((target("avx")))
+double hpglGeometry::polylineLengthAVX(const double * src, int count)
+{
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+
+    // Points i..i+3 against i+1..i+4
+    for (; i+4 < count; i += 4)
+    {
+        __m256d a0 = _mm256_loadu_pd(src + (2*i));
+        __m256d a1 = _mm256_loadu_pd(src + (2*i) + 4);
+        __m256d b0 = _mm256_loadu_pd(src + (2*i) + 2);
+        __m256d b1 = _mm256_loadu_pd(src + (2*i) + 6);
+        __m256d d0 = _mm256_sub_pd(b0, a0);
+        __m256d d1 = _mm256_sub_pd(b1, a1);
+        d0 = _mm256_mul_pd(d0, d0);
+        d1 = _mm256_mul_pd(d1, d1);
+        // lanes: segments i, i+2, i+1, i+3
+        __m256d sq = _mm256_hadd_pd(d0, d1);
+        sum = _mm256_add_pd(sum, _mm256_sqrt_pd(sq));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum);
+    double length = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (++i; i < count; ++i)
+    {
+        double dx = src[2*i] - src[(2*i)-2];
+        double dy = src[(2*i)+1] - src[(2*i)-1];
+        length += qSqrt((dx*dx) + (dy*dy));
+    }
+    return(length);
+}
+
+bool hpglGeometry::hasAVX()
+{
+    static const bool avx = __builtin_cpu_supports("avx");
+    return(avx);
+}
+#else
+double hpglGeometry::polylineLengthAVX(const double * src, int count)
+{
+    Q_UNUSED(src);
+    Q_UNUSED(count);
+    return 0;
+}
+
+bool hpglGeometry::hasAVX()
+{
+    return false;
+}
+#endif
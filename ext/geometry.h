@@ -0,0 +1,48 @@
+/**
+ * hpglGeometry - bulk geometry kernels header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLGEOMETRY_H
+#define HPGLGEOMETRY_H
+
+#include <QtCore>
+#include <QPolygon>
+#include <QLine>
+#include <QPolygonF>
+#include <QTransform>
+#include <QRectF>
+#include <QVector>
+
+namespace std {
+class hpglGeometry;
+}
+
+/**
+ * @brief The hpglGeometry class
+ * Operations over whole point arrays, so per-point Qt overhead
+ * (like QGraphicsItem::mapToScene) stays out of hot loops.
+ */
+class hpglGeometry
+{
+public:
+    static bool mapToDevice(const QTransform & transform, const QPolygonF & poly, QPolygon & points);
+    static bool mapToDeviceScalar(const QTransform & transform, const QPolygonF & poly, QPolygon & points);
+    static double polylineLength(const QPolygonF & poly);
+    static double polylineLengthScalar(const QPolygonF & poly);
+    static QVector<QPolygonF> clipPolyline(const QPolygonF & poly, const QRectF & rect);
+    static QPolygonF convexHull(QPolygonF points);
+    static double minimumRectAngle(QPolygonF points, bool minimumWidth);
+    static QVector<QLine> mergeAxisSegments(const QVector<QLine> & segments, int tolerance);
+    static QVector<QPolygon> chainSegments(const QVector<QLine> & segments, QPoint start);
+
+private:
+    friend class TestGeometry;  // tests/geometry checks each kernel on its own
+    static double polylineLengthSSE2(const double * src, int count);
+    static double polylineLengthAVX(const double * src, int count);
+    static bool hasAVX();
+    static void mergeRuns(QVector<QLine> & runs, int tolerance, bool vertical, QVector<QLine> & merged);
+    static bool clipSegment(const QPointF & a, const QPointF & b, const QRectF & rect,
+                            double & t0, double & t1);
+};
+
+#endif // HPGLGEOMETRY_H
@@ -192,6 +192,7 @@ QPersistentModelIndex ExtLoadFile::createHpglFile(file_uid _file)
 bool ExtLoadFile::parseHPGL(const QPersistentModelIndex index, QString * hpgl_text)
 {
     QPointF tail(0, 0);
+    bool relative = false;
 
     hpgl_text->remove('\n');
     int numCmds = hpgl_text->count(';');
@@ -214,16 +215,33 @@ bool ExtLoadFile::parseHPGL(const QPersistentModelIndex index, QString * hpgl_te
         // Parse opcode
         if (opcode == "PU")
         {
-            // Pen up - we assume a single line (two points)
+            // Pen up - we assume a single line (two points) unless relative
             int commaCount, newX, newY;
             cmdText.remove(0,2);
             commaCount = cmdText.count(',');
-            int i = commaCount - 1;
-            newX = cmdText.section(',', i, i).toInt();
-            i++;
-            newY = cmdText.section(',', i, i).toInt();
-            tail.setX(newX);
-            tail.setY(newY);
+            if (cmdText.isEmpty())
+            {
+                // Bare PU only lifts the pen
+            }
+            else if (relative)
+            {
+                for (int i = 0; i < commaCount; i++)
+                {
+                    newX = cmdText.section(',', i, i).toInt();
+                    i++;
+                    newY = cmdText.section(',', i, i).toInt();
+                    tail += QPointF(newX, newY);
+                }
+            }
+            else
+            {
+                int i = commaCount - 1;
+                newX = cmdText.section(',', i, i).toInt();
+                i++;
+                newY = cmdText.section(',', i, i).toInt();
+                tail.setX(newX);
+                tail.setY(newY);
+            }
         }
         else if (opcode == "PD")
         {
@@ -238,10 +256,42 @@ bool ExtLoadFile::parseHPGL(const QPersistentModelIndex index, QString * hpgl_te
                 i++;
                 int newY = cmdText.section(',', i, i).toInt();
 //                qDebug() << "= Found x: " << newX << " y: " << newY;
-                newItem << QPointF(newX, newY);
+                if (relative)
+                {
+                    tail += QPointF(newX, newY);
+                }
+                else
+                {
+                    tail = QPointF(newX, newY);
+                }
+                newItem << tail;
             }
             emit newPolygon(index, newItem);
         }
+        else if (opcode == "PA")
+        {
+            // Plot absolute
+            relative = false;
+        }
+        else if (opcode == "PR")
+        {
+            // Plot relative
+            relative = true;
+        }
+        else if (opcode == "PE")
+        {
+            // HP-GL/2 polyline encoded, one polygon per pen down run
+            QVector<QPolygonF> strokes;
+            if (!hpglEncoder::decodePE(cmdText.mid(2).toLatin1(), tail, strokes))
+            {
+                qDebug() << "Malformed PE command.";
+                return false;
+            }
+            for (int i2 = 0; i2 < strokes.length(); ++i2)
+            {
+                emit newPolygon(index, strokes.at(i2));
+            }
+        }
         else if (opcode == "IN")
         {
             // Begin plotting (automatically handled)
@@ -16,6 +16,7 @@
 
 #include "settings.h"
 #include "hpgllistmodel.h"
+#include "encoder.h"
 
 namespace std {
 class ExtLoadFile;
@@ -0,0 +1,497 @@
+/**
+ * ExtNest - worker thread
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "nest.h"
+#include "mainwindow.h"
+
+ExtNest::ExtNest(hpglListModel *model)
+{
+    cancelFlag.store(0);
+    hpglModel = model;
+    cell = 1;
+    sheetHeight = 0;
+    budget = 0;
+}
+
+ExtNest::~ExtNest()
+{
+    //
+}
+
+/**
+ * @brief ExtNest::process
+ * Nests files by their outlines rather than bounding boxes. Each ordering
+ * of the parts is laid out bottom-left on its own thread, and the shortest
+ * layout found within the time budget wins.
+ */
+void ExtNest::process()
+{
+    QSettings settings;
+
+    double padding = settings.value("device/cutoutboxes/padding", SETDEF_DEVICE_CUTOUTBOXES_PADDING).toDouble();
+    if (settings.value("device/width/type", SETDEF_DEVICE_WDITH_TYPE).toInt() == deviceWidth_t::CM)
+    {
+        padding = padding * 2.54;
+    }
+    padding = padding * 1016.0;
+
+    cell = settings.value("nest/resolution", SETDEF_NEST_RESOLUTION).toDouble() * 40.0; // mm to plotter units
+    if (cell < 1)
+    {
+        cell = 1;
+    }
+    budget = settings.value("nest/timebudget", SETDEF_NEST_TIMEBUDGET).toInt();
+    int rotations = qBound(1, settings.value("nest/rotations", SETDEF_NEST_ROTATIONS).toInt(), 36);
+
+    QLineF widthLine = MainWindow::get_widthLine();
+    double width = widthLine.p2().y() - widthLine.p1().y();
+    sheetHeight = static_cast<int>(width / cell);
+
+    budgetTimer.start();
+    if (!buildParts(padding, rotations))
+    {
+        emit finished();
+        return;
+    }
+    if (parts.isEmpty())
+    {
+        emit statusUpdate("Nothing to nest.");
+        emit finished();
+        return;
+    }
+    emit progress(10);
+
+    // Orderings to try, biggest pieces first in different senses
+    QVector<QVector<int> > orders;
+    for (int key = 0; key < 4; ++key)
+    {
+        QVector<QPair<double, int> > keyed;
+        for (int i = 0; i < parts.length(); ++i)
+        {
+            const nest_mask & mask = parts.at(i).masks.first();
+            double value;
+            switch (key)
+            {
+            case 0:
+                value = parts.at(i).area;
+                break;
+            case 1:
+                value = qMax(mask.width, mask.height);
+                break;
+            case 2:
+                value = qMin(mask.width, mask.height);
+                break;
+            default:
+                value = (double)mask.width * mask.height;
+                break;
+            }
+            keyed.push_back(qMakePair(-value, i));
+        }
+        std::stable_sort(keyed.begin(), keyed.end());
+        QVector<int> order;
+        for (int i = 0; i < keyed.length(); ++i)
+        {
+            order.push_back(keyed.at(i).second);
+        }
+        orders.push_back(order);
+    }
+
+    QVector<QFuture<nest_layout> > futures;
+    for (int i = 0; i < orders.length(); ++i)
+    {
+        futures.push_back(QtConcurrent::run(this, &ExtNest::layout, orders.at(i)));
+    }
+
+    int best = -1;
+    bool timedOut = false;
+    for (int i = 0; i < futures.length(); ++i)
+    {
+        nest_layout result = futures[i].result();
+        timedOut |= !result.complete;
+        if (best < 0 || result.length < futures[best].result().length)
+        {
+            best = i;
+        }
+        emit progress(10 + ((90 * (i+1)) / futures.length()));
+    }
+
+    if (cancelFlag.load())
+    {
+        statusUpdate("Cancelling auto arrange.", Qt::darkRed);
+        emit finished();
+        return;
+    }
+
+    nest_layout result = futures[best].result();
+    qint64 partArea = 0;
+    hpglModel->setPanels(QVector<hpgl_panel>()); // everything is back on the roll
+    for (int i = 0; i < result.placements.length(); ++i)
+    {
+        const nest_placement & placement = result.placements.at(i);
+        const nest_part & part = parts.at(placement.part);
+        QTransform transform = part.masks.at(placement.mask).transform
+                * QTransform::fromTranslate(placement.x * cell, placement.y * cell);
+        partArea += part.area;
+        emit nestedItem(part.index, transform);
+    }
+
+    // Compare against packing bounding boxes
+    double nestLength = result.length * cell;
+    double rectLength = rectanglePackLength(padding, width);
+    double usedArea = partArea * cell * cell;
+    QString report = "Nested " + QString::number(parts.length()) + " files in "
+            + QString::number(nestLength / 1016.0, 'f', 1) + " inches of vinyl, "
+            + QString::number((100.0 * usedArea) / qMax(1.0, nestLength * width), 'f', 0) + "% used";
+    if (rectLength > 0)
+    {
+        report += " (rectangle packing: " + QString::number(rectLength / 1016.0, 'f', 1) + " inches, "
+                + QString::number((100.0 * usedArea) / (rectLength * width), 'f', 0) + "% used)";
+    }
+    report += ".";
+    if (timedOut)
+    {
+        report += " Time budget ran out, some files were placed without searching.";
+    }
+    emit statusUpdate(report);
+    emit finished();
+}
+
+void ExtNest::cancel()
+{
+    cancelFlag.store(1);
+}
+
+/**
+ * @brief ExtNest::buildParts
+ * Copies every file's strokes out of the model and rasterizes each allowed
+ * rotation. The current rotation and scale of a file are kept, position is not.
+ */
+bool ExtNest::buildParts(double padding, int rotations)
+{
+    hpglSnapshot job = hpglModel->snapshot();
+
+    parts.clear();
+    for (int i = 0; i < job->files.length(); ++i)
+    {
+        const hpgl_snapshot_file & file = job->files.at(i);
+        nest_part part;
+        QVector<QPolygonF> polys = file.geometry;
+        QTransform base;
+
+        part.index = file.index;
+        QTransform scene = file.transform;
+        base = QTransform(scene.m11(), scene.m12(), scene.m21(), scene.m22(), 0, 0);
+        if (!file.cutout_box.isEmpty())
+        {
+            polys.push_back(file.cutout_box);
+        }
+
+        if (polys.isEmpty())
+        {
+            continue;
+        }
+        for (int i2 = 0; i2 < polys.length(); ++i2)
+        {
+            part.bounds = part.bounds.united(base.map(polys.at(i2)).boundingRect());
+        }
+
+        part.area = 0;
+        for (int r = 0; r < rotations; ++r)
+        {
+            qint64 area = 0;
+            nest_mask mask = rasterize(polys, base * QTransform().rotate((360.0 * r) / rotations),
+                                       padding, &area);
+            part.masks.push_back(mask);
+            if (r == 0)
+            {
+                part.area = area;
+            }
+        }
+        parts.push_back(part);
+
+        if (cancelFlag.load())
+        {
+            statusUpdate("Cancelling auto arrange.", Qt::darkRed);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief ExtNest::rasterize
+ * Closed strokes are filled, open ones drawn, and everything is grown by
+ * half the padding (plus a cell for rounding) so neighbours keep their gap.
+ * @param area - set to the cells covered without padding
+ */
+nest_mask ExtNest::rasterize(const QVector<QPolygonF> & polys, const QTransform & transform,
+                             double padding, qint64 * area)
+{
+    nest_mask mask;
+    QPainterPath outline;
+    QVector<QPolygonF> mapped;
+    QRectF bounds;
+    double grow = (padding / 2.0) + cell;
+
+    for (int i = 0; i < polys.length(); ++i)
+    {
+        QPolygonF poly = transform.map(polys.at(i));
+        bounds = bounds.isNull() ? poly.boundingRect() : bounds.united(poly.boundingRect());
+        if (poly.length() > 2 && poly.isClosed())
+        {
+            outline.addPolygon(poly);
+        }
+        mapped.push_back(poly);
+    }
+    outline.setFillRule(Qt::WindingFill);
+
+    QPointF origin = bounds.topLeft() - QPointF(grow, grow);
+    mask.width = qCeil((bounds.width() + (2*grow)) / cell) + 1;
+    mask.height = qCeil((bounds.height() + (2*grow)) / cell) + 1;
+    mask.words = (mask.height + 63) / 64;
+    mask.bits.fill(0, mask.width * mask.words);
+    mask.transform = transform * QTransform::fromTranslate(-origin.x(), -origin.y());
+
+    // Once without padding for the area, once with it for the collision mask
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        QImage image(mask.width, mask.height, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing, false);
+        painter.scale(1.0 / cell, 1.0 / cell);
+        painter.translate(-origin);
+        painter.fillPath(outline, Qt::black);
+        painter.setPen(QPen(Qt::black, (pass == 0) ? 0 : (2*grow), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        for (int i = 0; i < mapped.length(); ++i)
+        {
+            painter.drawPolyline(mapped.at(i));
+        }
+        painter.end();
+
+        for (int y = 0; y < mask.height; ++y)
+        {
+            const QRgb * line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            for (int x = 0; x < mask.width; ++x)
+            {
+                if (qAlpha(line[x]) == 0)
+                {
+                    continue;
+                }
+                if (pass == 0)
+                {
+                    ++(*area);
+                }
+                else
+                {
+                    mask.bits[(x * mask.words) + (y / 64)] |= (Q_UINT64_C(1) << (y % 64));
+                }
+            }
+        }
+    }
+    return(mask);
+}
+
+/**
+ * @brief ExtNest::layout
+ * Greedy bottom-left placement: each part, at whichever rotation, goes to
+ * the position with the nearest right edge, then the lowest. Runs on a pool thread.
+ */
+nest_layout ExtNest::layout(const QVector<int> & order)
+{
+    nest_layout result;
+    int sheetWords = (sheetHeight + 63) / 64;
+    int capacity = 1;
+
+    for (int i = 0; i < parts.length(); ++i)
+    {
+        int longest = 0;
+        for (int m = 0; m < parts.at(i).masks.length(); ++m)
+        {
+            longest = qMax(longest, parts.at(i).masks.at(m).width);
+        }
+        capacity += longest;
+    }
+
+    QVector<quint64> sheet(capacity * sheetWords, 0);
+    result.length = 0;
+    result.complete = true;
+
+    for (int i = 0; i < order.length(); ++i)
+    {
+        const nest_part & part = parts.at(order.at(i));
+        nest_placement best;
+        int bestRight = INT_MAX;
+        bool searching = !cancelFlag.load() && budgetTimer.elapsed() < budget;
+
+        best.part = order.at(i);
+        best.mask = -1;
+        if (!searching)
+        {
+            result.complete = false;
+        }
+
+        for (int m = 0; m < part.masks.length(); ++m)
+        {
+            const nest_mask & mask = part.masks.at(m);
+            if (mask.height > sheetHeight)
+            {
+                continue;
+            }
+            // Past the used length always fits, so only search in front of it
+            bool placed = false;
+            for (int x0 = searching ? 0 : result.length; x0 <= result.length && !placed; ++x0)
+            {
+                if (searching && (cancelFlag.load() || budgetTimer.elapsed() >= budget))
+                {
+                    // Out of time mid scan, go straight to the free end
+                    searching = false;
+                    result.complete = false;
+                    x0 = result.length;
+                }
+                if ((x0 + mask.width) >= bestRight)
+                {
+                    break;
+                }
+                for (int y0 = 0; y0 <= (sheetHeight - mask.height); ++y0)
+                {
+                    if (!collides(sheet, sheetWords, mask, x0, y0))
+                    {
+                        best.mask = m;
+                        best.x = x0;
+                        best.y = y0;
+                        bestRight = x0 + mask.width;
+                        placed = true;
+                        break;
+                    }
+                }
+            }
+            if (!searching && best.mask >= 0)
+            {
+                break;
+            }
+        }
+
+        if (best.mask < 0)
+        {
+            // Too wide for the roll at every rotation, give it the narrowest one
+            best.mask = 0;
+            for (int m = 1; m < part.masks.length(); ++m)
+            {
+                if (part.masks.at(m).height < part.masks.at(best.mask).height)
+                {
+                    best.mask = m;
+                }
+            }
+            best.x = result.length;
+            best.y = 0;
+        }
+
+        const nest_mask & mask = part.masks.at(best.mask);
+        occupy(sheet, sheetWords, mask, best.x, best.y);
+        result.length = qMax(result.length, best.x + mask.width);
+        result.placements.push_back(best);
+    }
+    return(result);
+}
+
+/**
+ * @brief ExtNest::collides
+ * Tests the mask shifted up by y0 bits against sheet columns from x0.
+ */
+bool ExtNest::collides(const QVector<quint64> & sheet, int sheetWords,
+                       const nest_mask & mask, int x0, int y0)
+{
+    const int wordShift = y0 / 64;
+    const int bitShift = y0 % 64;
+    const quint64 * maskBits = mask.bits.constData();
+    const quint64 * sheetBits = sheet.constData();
+
+    for (int px = 0; px < mask.width; ++px)
+    {
+        const quint64 * column = maskBits + (px * mask.words);
+        const quint64 * target = sheetBits + ((x0 + px) * sheetWords);
+        for (int k = 0; k < mask.words; ++k)
+        {
+            quint64 word = column[k];
+            int index = k + wordShift;
+            if (word == 0 || index >= sheetWords)
+            {
+                continue;
+            }
+            if (target[index] & (word << bitShift))
+            {
+                return true;
+            }
+            if (bitShift && (index+1) < sheetWords && (target[index+1] & (word >> (64 - bitShift))))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ExtNest::occupy(QVector<quint64> & sheet, int sheetWords,
+                     const nest_mask & mask, int x0, int y0)
+{
+    const int wordShift = y0 / 64;
+    const int bitShift = y0 % 64;
+
+    for (int px = 0; px < mask.width; ++px)
+    {
+        const quint64 * column = mask.bits.constData() + (px * mask.words);
+        quint64 * target = sheet.data() + ((x0 + px) * sheetWords);
+        for (int k = 0; k < mask.words; ++k)
+        {
+            int index = k + wordShift;
+            if (index >= sheetWords)
+            {
+                break;
+            }
+            target[index] |= (column[k] << bitShift);
+            if (bitShift && (index+1) < sheetWords)
+            {
+                target[index+1] |= (column[k] >> (64 - bitShift));
+            }
+        }
+    }
+}
+
+/**
+ * @brief ExtNest::rectanglePackLength
+ * What ExtBinPack's bounding box packing would use, for the report.
+ */
+double ExtNest::rectanglePackLength(double padding, double width)
+{
+    rbp::MaxRectsBinPack mrPacker;
+    QVector<QRectF> rects;
+    double total = 0;
+    double length = 0;
+
+    for (int i = 0; i < parts.length(); ++i)
+    {
+        QRectF rect = parts.at(i).bounds.marginsAdded(QMarginsF(0, padding, padding, 0));
+        rects.push_back(rect);
+        total += qMax(rect.width(), rect.height());
+    }
+
+    mrPacker.Init(width, total);
+    for (int i = 0; i < rects.length(); ++i)
+    {
+        rbp::Rect packed = mrPacker.Insert(rects.at(i).width(), rects.at(i).height(),
+                                           rbp::MaxRectsBinPack::FreeRectChoiceHeuristic::RectBottomLeftRule);
+        if (packed.height == 0)
+        {
+            return 0;
+        }
+        length = qMax(length, (double)(packed.y + packed.height));
+    }
+    return(length);
+}
+
+void ExtNest::statusUpdate(QString _consoleStatus)
+{
+    emit statusUpdate(_consoleStatus, Qt::black);
+}
@@ -0,0 +1,104 @@
+/**
+ * ExtNest - worker thread header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef EXTNEST_H
+#define EXTNEST_H
+
+#include <QtCore>
+#include <QPolygonF>
+#include <QGraphicsPolygonItem>
+#include <QVector>
+#include <QtMath>
+#include <QTransform>
+#include <QImage>
+#include <QPainter>
+#include <QPainterPath>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+
+#include "settings.h"
+#include "hpgllistmodel.h"
+#include "RectangleBinPack/MaxRectsBinPack.h"
+
+/**
+ * One file at one rotation, rasterized. Columns run along the roll
+ * (scene x), and each column is a bitset across the roll (scene y).
+ */
+struct nest_mask {
+    int width;              // columns
+    int height;             // bits used per column
+    int words;              // quint64 per column
+    QVector<quint64> bits;  // column major
+    QTransform transform;   // item to scene, with the mask origin at (0,0)
+};
+
+// Every rotation of one file
+struct nest_part {
+    QPersistentModelIndex index;
+    QVector<nest_mask> masks;
+    qint64 area;            // cells covered by the outline itself, without padding
+    QRectF bounds;          // file coordinates at its own rotation and scale
+};
+
+// Where one part went
+struct nest_placement {
+    int part;
+    int mask;
+    int x;
+    int y;
+};
+
+// A finished layout for one ordering of the parts
+struct nest_layout {
+    QVector<nest_placement> placements;
+    int length;             // columns used
+    bool complete;          // false if the time budget ran out part way
+};
+
+namespace std {
+class ExtNest;
+}
+
+class ExtNest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ExtNest(hpglListModel * model);
+    ~ExtNest();
+
+public slots:
+    void process();
+    void cancel();
+
+signals:
+    void progress(int percent);
+    void finished();
+    void statusUpdate(QString text, QColor textColor);
+    void nestedItem(QPersistentModelIndex index, QTransform transform);
+
+private:
+    void statusUpdate(QString _consoleStatus);
+    bool buildParts(double padding, int rotations);
+    nest_mask rasterize(const QVector<QPolygonF> & polys, const QTransform & transform,
+                        double padding, qint64 * area);
+    nest_layout layout(const QVector<int> & order);
+    double rectanglePackLength(double padding, double width);
+
+    static bool collides(const QVector<quint64> & sheet, int sheetWords,
+                         const nest_mask & mask, int x0, int y0);
+    static void occupy(QVector<quint64> & sheet, int sheetWords,
+                       const nest_mask & mask, int x0, int y0);
+
+    hpglListModel * hpglModel;
+    QAtomicInt cancelFlag;
+    QVector<nest_part> parts;
+    double cell;            // plotter units per raster cell
+    int sheetHeight;        // cells across the roll
+    QElapsedTimer budgetTimer;
+    qint64 budget;          // ms
+};
+
+#endif // EXTNEST_H
@@ -0,0 +1,186 @@
+/**
+ * ExtOptimize - worker thread
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "optimize.h"
+
+ExtOptimize::ExtOptimize(hpglListModel *model)
+{
+    cancelFlag.store(0);
+    hpglModel = model;
+    seed = 2463534242u;
+}
+
+ExtOptimize::~ExtOptimize()
+{
+    //
+}
+
+/**
+ * @brief ExtOptimize::process
+ * Anneals until the time budget runs out or the operator stops it.
+ * Moves are swapping two files, moving one file in the order, or
+ * changing how one file may be turned.
+ */
+void ExtOptimize::process()
+{
+    QSettings settings;
+    QVector<QSizeF> sizes;
+    QElapsedTimer timer, publishTimer;
+
+    timer.start();
+    if (!ExtBinPack::fileSizes(hpglModel, indexes, sizes) || sizes.isEmpty())
+    {
+        emit finished();
+        return;
+    }
+
+    QLineF widthLine = MainWindow::get_widthLine();
+    hpglStripPacker packer(widthLine.p2().y() - widthLine.p1().y());
+    qint64 budget = settings.value("optimize/time", SETDEF_OPTIMIZE_TIME).toInt();
+
+    QVector<int> order = hpglStripPacker::longestSideOrder(sizes);
+    QVector<char> turns(sizes.length(), hpglStripPacker::TURN_ANY);
+    QVector<QRectF> rects, bestRects;
+    double length, startLength, bestLength;
+
+    if (!packer.pack(sizes, order, turns, rects, length))
+    {
+        emit statusUpdate("A file is wider than the vinyl, can't optimize.", Qt::darkRed);
+        emit finished();
+        return;
+    }
+    startLength = bestLength = length;
+    bestRects = rects;
+    publish(bestRects);
+    publishTimer.start();
+
+    double currentEnergy = energy(rects, length);
+    double bestEnergy = currentEnergy;
+    double startTemp = 0.02 * length;
+    double endTemp = 0.0005 * length;
+    bool unpublished = false;
+    int iterations = 0;
+
+    while (sizes.length() > 1 && !cancelFlag.load() && timer.elapsed() < budget)
+    {
+        QVector<int> trialOrder = order;
+        QVector<char> trialTurns = turns;
+        int a = random() % sizes.length();
+        int b = random() % sizes.length();
+
+        switch (random() % 3)
+        {
+        case 0:
+            qSwap(trialOrder[a], trialOrder[b]);
+            break;
+        case 1:
+            trialOrder.move(a, b);
+            break;
+        default:
+            trialTurns[trialOrder.at(a)] = (trialTurns.at(trialOrder.at(a)) + 1) % 3;
+            break;
+        }
+
+        QVector<QRectF> trialRects;
+        double trialLength;
+        ++iterations;
+        if (!packer.pack(sizes, trialOrder, trialTurns, trialRects, trialLength))
+        {
+            continue;
+        }
+
+        // Geometric cooling over the time budget
+        double temp = startTemp * qPow(endTemp / startTemp, (double)timer.elapsed() / budget);
+        double trialEnergy = energy(trialRects, trialLength);
+        if (trialEnergy <= currentEnergy
+                || qExp((currentEnergy - trialEnergy) / temp) > (random() / 4294967296.0))
+        {
+            order = trialOrder;
+            turns = trialTurns;
+            currentEnergy = trialEnergy;
+            if (trialEnergy < bestEnergy)
+            {
+                bestEnergy = trialEnergy;
+                bestLength = trialLength;
+                bestRects = trialRects;
+                unpublished = true;
+            }
+        }
+
+        if (unpublished && publishTimer.elapsed() >= OPTIMIZE_PUBLISH_INTERVAL_MS)
+        {
+            publish(bestRects);
+            publishTimer.restart();
+            unpublished = false;
+            emit progress(qMin<qint64>(100, (100 * timer.elapsed()) / qMax<qint64>(1, budget)));
+        }
+    }
+
+    if (unpublished)
+    {
+        publish(bestRects);
+    }
+
+    emit statusUpdate("Optimized layout: " + QString::number(bestLength / 1016.0, 'f', 1) + " inches, "
+                      + QString::number((100.0 * (startLength - bestLength)) / startLength, 'f', 1)
+                      + "% shorter after " + QString::number(iterations) + " layouts in "
+                      + QString::number(timer.elapsed() / 1000.0, 'f', 1) + "s.");
+    emit finished();
+}
+
+void ExtOptimize::cancel()
+{
+    cancelFlag.store(1);
+}
+
+/**
+ * @brief ExtOptimize::publish
+ * Sends a layout to the scene, turning packer coordinates (x across the roll) into scene ones.
+ */
+void ExtOptimize::publish(const QVector<QRectF> & rects)
+{
+    if (!hpglModel->panels().isEmpty())
+    {
+        hpglModel->setPanels(QVector<hpgl_panel>()); // everything is back on the roll
+    }
+    for (int i = 0; i < indexes.length(); ++i)
+    {
+        QRectF rect;
+        rect.setX(rects.at(i).y());
+        rect.setY(rects.at(i).x());
+        rect.setWidth(rects.at(i).height());
+        rect.setHeight(rects.at(i).width());
+        emit packedRect(indexes.at(i), rect);
+    }
+}
+
+/**
+ * @brief ExtOptimize::energy
+ * Vinyl length, plus a little for how far along the roll files sit on average,
+ * so moves that compact a layout without shortening it yet still count.
+ */
+double ExtOptimize::energy(const QVector<QRectF> & rects, double length)
+{
+    double tops = 0;
+
+    for (int i = 0; i < rects.length(); ++i)
+    {
+        tops += rects.at(i).bottom();
+    }
+    return(length + ((0.01 * tops) / qMax(1, rects.length())));
+}
+
+// xorshift32
+quint32 ExtOptimize::random()
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return(seed);
+}
+
+void ExtOptimize::statusUpdate(QString _consoleStatus)
+{
+    emit statusUpdate(_consoleStatus, Qt::black);
+}
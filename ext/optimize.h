@@ -0,0 +1,60 @@
+/**
+ * ExtOptimize - worker thread header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef EXTOPTIMIZE_H
+#define EXTOPTIMIZE_H
+
+#include <QtCore>
+#include <QVector>
+#include <QtMath>
+
+#include "settings.h"
+#include "hpgllistmodel.h"
+#include "strippack.h"
+#include "binpack.h"
+
+// Time between layouts sent to the scene while improving
+#define OPTIMIZE_PUBLISH_INTERVAL_MS (500)
+
+namespace std {
+class ExtOptimize;
+}
+
+/**
+ * @brief The ExtOptimize class
+ * Anytime layout search: simulated annealing over insertion order and
+ * orientation, packed by hpglStripPacker. Better layouts are sent to the
+ * scene as they're found, and cancelling keeps the best one.
+ */
+class ExtOptimize : public QObject
+{
+    Q_OBJECT
+
+public:
+    ExtOptimize(hpglListModel * model);
+    ~ExtOptimize();
+
+public slots:
+    void process();
+    void cancel();
+
+signals:
+    void progress(int percent);
+    void finished();
+    void statusUpdate(QString text, QColor textColor);
+    void packedRect(QPersistentModelIndex index, QRectF rect);
+
+private:
+    void statusUpdate(QString _consoleStatus);
+    void publish(const QVector<QRectF> & rects);
+    double energy(const QVector<QRectF> & rects, double length);
+    quint32 random();
+
+    hpglListModel * hpglModel;
+    QAtomicInt cancelFlag;
+    QVector<QPersistentModelIndex> indexes;
+    quint32 seed;
+};
+
+#endif // EXTOPTIMIZE_H
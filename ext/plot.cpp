@@ -7,14 +7,40 @@
 ExtPlot::ExtPlot(hpglListModel * model)
 {
     runPerimeterFlag = false;
+    resumeFlag = false;
+    plotPanel = -1;
+    sessionLog = NULL;
     hpglModel = model;
+    state = IDLE;
+    pacingTimer = new QTimer(this);
+    pacingTimer->setSingleShot(true);
+    connect(pacingTimer, SIGNAL(timeout()), this, SLOT(handle_pacingTimeout()));
+    drainTimer = new QTimer(this);
+    drainTimer->setSingleShot(true);
+    connect(drainTimer, SIGNAL(timeout()), this, SLOT(handle_drainTimeout()));
+    reportTimer = new QTimer(this);
+    reportTimer->setInterval(PLOT_REPORT_INTERVAL_MS);
+    connect(reportTimer, SIGNAL(timeout()), this, SLOT(handle_reportTimeout()));
 }
 
 ExtPlot::ExtPlot(hpglListModel * model, QRectF _perimeter)
 {
     runPerimeterFlag = true;
+    resumeFlag = false;
+    plotPanel = -1;
+    sessionLog = NULL;
     perimeterRect = _perimeter;
     hpglModel = model;
+    state = IDLE;
+    pacingTimer = new QTimer(this);
+    pacingTimer->setSingleShot(true);
+    connect(pacingTimer, SIGNAL(timeout()), this, SLOT(handle_pacingTimeout()));
+    drainTimer = new QTimer(this);
+    drainTimer->setSingleShot(true);
+    connect(drainTimer, SIGNAL(timeout()), this, SLOT(handle_drainTimeout()));
+    reportTimer = new QTimer(this);
+    reportTimer->setInterval(PLOT_REPORT_INTERVAL_MS);
+    connect(reportTimer, SIGNAL(timeout()), this, SLOT(handle_reportTimeout()));
 }
 
 ExtPlot::~ExtPlot()
@@ -114,7 +140,8 @@ QPointer<QSerialPort> ExtPlot::openSerial()
         _port->setFlowControl(QSerialPort::NoFlowControl);
     }
 
-    _port->open(QIODevice::WriteOnly);
+    // ReadWrite so device responses arrive through readyRead()
+    _port->open(QIODevice::ReadWrite);
     if (_port->isOpen())
     {
         qDebug() << "Flow control: " << _port->flowControl();
@@ -140,34 +167,156 @@ void ExtPlot::closeSerial()
     emit serialClosed();
 }
 
+void ExtPlot::setResumeFromCheckpoint(bool resume)
+{
+    resumeFlag = resume;
+}
+
+/**
+ * @brief ExtPlot::setPanel
+ * Plots only the files on one panel, relative to its corner.
+ * @param panel - model panel, or -1 for the roll
+ */
+void ExtPlot::setPanel(int panel)
+{
+    plotPanel = panel;
+}
+
+QString ExtPlot::checkpointPath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return(dir + "/plot_checkpoint.dat");
+}
+
+bool ExtPlot::hasCheckpoint()
+{
+    QSettings settings;
+    return(settings.value("plot/checkpoint", SETDEF_PLOT_CHECKPOINT).toBool()
+           && QFile::exists(checkpointPath()));
+}
+
+void ExtPlot::clearCheckpoint()
+{
+    QSettings settings;
+    settings.remove("plot/checkpoint");
+    QFile::remove(checkpointPath());
+}
+
 void ExtPlot::cancel()
 {
-    cancelPlotFlag = true;
+    if (state == IDLE || state == CANCELLED)
+    {
+        return;
+    }
+    state = CANCELLED;
+    pacingTimer->stop();
+    pacingPending = false;
+    if (runPerimeterFlag)
+    {
+        emit statusUpdate("Bailing out of plot, cancelled!", Qt::darkRed);
+    }
+    else
+    {
+        emit statusUpdate("Bailing out of plot, cancelled! Checkpoint saved at stroke "
+                          + QString::number(done_index) + ".", Qt::darkRed);
+    }
+    finishPlot();
+}
+
+/**
+ * @brief ExtPlot::pause
+ * Stops feeding strokes and lifts the pen once the queued strokes are done.
+ */
+void ExtPlot::pause()
+{
+    if (state != STREAMING)
+    {
+        return;
+    }
+    state = PAUSED;
+    writeStream("PU;", 3);
+    emit statusUpdate("Pausing, waiting for the device to drain.");
+}
+
+void ExtPlot::resume()
+{
+    if (state != PAUSED)
+    {
+        return;
+    }
+    state = STREAMING;
+    lastAckTime = -1;
+    emit statusUpdate("Resuming plot.");
+    do_plotNext();
 }
 
 void ExtPlot::process()
 {
     // Variables
-    QPointer<QSerialPort> _port;
     QSettings settings;
+    int start_index = 0;
 
-    hpglList_index = 0;
-    hpgl_obj_index = 0;
-    cancelPlotFlag = false;
-    _port = openSerial();
+    pacingPending = false;
+    bytesQueued = 0;
+    bytesSent = 0;
+    strokeMarkers.clear();
+    ackedMarkers.clear();
 
-    emit statusUpdate("Plotting file!");
+    // Settings are read once here rather than for every stroke
+    incremental = settings.value("device/incremental", SETDEF_DEVICE_INCREMENTAL).toBool();
+    deviceBuffer = qMax(0, settings.value("device/buffer", SETDEF_DEVICE_BUFFER).toInt());
+    motion = ExtEta::motionProfile();
+    encoder = hpglEncoder(static_cast<deviceEncoding_t>(settings.value("device/encoding", SETDEF_DEVICE_ENCODING).toInt()));
 
-    emit statusUpdate("There are " + QString::number(hpglModel->rowCount()) + " hpgl items to plot.");
+    if (!runPerimeterFlag)
+    {
+        if (resumeFlag)
+        {
+            if (!loadJob())
+            {
+                emit statusUpdate("No usable plot checkpoint to resume from.", Qt::darkRed);
+                emit finished();
+                return;
+            }
+            start_index = settings.value("plot/checkpoint/stroke", SETDEF_PLOT_CHECKPOINT_STROKE).toInt();
+            if (start_index < 0 || start_index > strokes.length())
+            {
+                start_index = 0;
+            }
+            emit statusUpdate("Resuming plot from stroke " + QString::number(start_index)
+                              + " of " + QString::number(strokes.length()) + ".");
+        }
+        else
+        {
+            emit statusUpdate("There are " + QString::number(hpglModel->rowCount()) + " hpgl items to plot.");
+            if (hpglModel->rowCount() == 0 || !encodeJob())
+            {
+                emit statusUpdate("Can't plot!", Qt::darkRed);
+                emit finished();
+                return;
+            }
+            saveJob();
+        }
+    }
+    stroke_index = start_index;
+    ack_index = start_index;
+    done_index = start_index;
+
+    state = CONNECTING;
+    _port = openSerial();
 
-    if (_port.isNull() || !_port->isOpen() || hpglModel->rowCount() == 0)
+    if (_port.isNull() || !_port->isOpen())
     {
         emit statusUpdate("Can't plot!", Qt::darkRed);
+        state = IDLE;
         emit finished();
         return;
     }
 
-    qDebug() << "do perim: " << runPerimeterFlag;
+    connect(_port, SIGNAL(bytesWritten(qint64)), this, SLOT(handle_bytesWritten(qint64)));
+    connect(_port, SIGNAL(readyRead()), this, SLOT(handle_readyRead()));
+
     if (runPerimeterFlag)
     {
         QPointF point;
@@ -193,153 +342,723 @@ void ExtPlot::process()
         retval += QString::number(static_cast<int>(point.y()));
         retval += ",0,0;SP0;IN;";
         qDebug() << "perimeter: " << retval;
-        _port->write(retval.toStdString().c_str());
-        _port->flush();
-        closeSerial();
-        emit finished();
+        state = DRAINING;
+        QByteArray perimeter = retval.toLatin1();
+        writeStream(perimeter.constData(), perimeter.length());
         return;
     }
 
+    emit statusUpdate("Plotting file!");
+
     // explain the situation
-    if (settings.value("cutter/axis", SETDEF_DEVICE_SPEED_TRAVEL).toBool())
+    if (incremental)
     {
-        emit statusUpdate("Cutting with axis speed delay");
+        emit statusUpdate("Cutting with incremental speed delay");
     }
     else
     {
-        emit statusUpdate("Cutting with absolute speed delay");
+        emit statusUpdate("Cutting without delay, limited by serial buffer");
     }
 
-    _port->write("IN;SP1;");
+    checkpointTimer.start();
+    openSessionLog();
+    state = STREAMING;
+    QByteArray preamble = encoder.begin();
+    if (stroke_index > 0 && stroke_index < strokes.length())
+    {
+        preamble += encoder.seek(strokes.at(stroke_index).start);
+    }
+    writeStream(preamble.constData(), preamble.length());
+
+    timeBefore.resize(strokes.length() + 1);
+    timeBefore[0] = 0;
+    for (int i = 0; i < strokes.length(); ++i)
+    {
+        timeBefore[i+1] = timeBefore.at(i) + strokes.at(i).time;
+    }
+    bytesTotal = preamble.length() + jobStream.length();
+    if (stroke_index < strokes.length())
+    {
+        bytesTotal -= strokes.at(stroke_index).offset;
+    }
+    reportBytes = 0;
+    throughput = 0;
+    reportTimer->start();
 
     do_plotNext();
 }
 
-void ExtPlot::do_plotNext()
+/**
+ * @brief ExtPlot::encodeJob
+ * Encodes every stroke of every file into one stream up front, so streaming
+ * (and resuming) is only a matter of writing byte ranges. Objects that start
+ * where the previous one ended are chained into a single pen down.
+ * @return - false if a stroke is out of bounds
+ */
+bool ExtPlot::encodeJob()
 {
+    QPoint last_point(0, 0);
+    qint64 absoluteBytes = 0;
+    int objectCount = 0;
+
+    jobStream.clear();
+    strokes.clear();
+    encoder.begin(); // resets the pen, the preamble itself is written when streaming
+
+    // The model stays free for the operator while the job is encoded
+    hpglSnapshot job = hpglModel->snapshot();
+    const QVector<hpgl_panel> & panels = job->panels;
+    QPointF origin;
+    QRectF clipRect;    // in panel coordinates, only set for lengths of roll
+    if (plotPanel >= 0 && plotPanel < panels.length())
+    {
+        origin = panels.at(plotPanel).rect.topLeft();
+        if (panels.at(plotPanel).roll)
+        {
+            clipRect = QRectF(QPointF(0, 0), panels.at(plotPanel).rect.size());
+        }
+    }
+
+    // Cutout boxes are cut last, together, so edges they share are cut once
     QSettings settings;
-    double time = 0;
-    QModelIndex index;
-    QGraphicsItemGroup * itemGroup;
-    QVector<QGraphicsPolygonItem*> * items;
+    bool sharedEdges = settings.value("device/cutoutboxes", SETDEF_DEVICE_CUTOUTBOXES).toBool()
+            && settings.value("device/cutoutboxes/shared", SETDEF_DEVICE_CUTOUTBOXES_SHARED).toBool();
+    QVector<QPolygon> boxes;
+
+    // Stacked duplicates anywhere in the job are only cut once
+    hpglDedup dedup(settings.value("device/dedup/tolerance", SETDEF_DEVICE_DEDUP_TOLERANCE).toDouble() / ETA_UNITS_TO_MM);
+    bool dedupEnabled = settings.value("device/dedup", SETDEF_DEVICE_DEDUP).toBool();
 
-    if (hpglList_index >= hpglModel->rowCount())
+    for (int i = 0; i < job->files.length(); ++i)
     {
-        emit statusUpdate("No more hpgl files left to plot.");
-        closeSerial();
-        emit finished();
-        return;
+        const hpgl_snapshot_file & file = job->files.at(i);
+        if (file.panel != (clipRect.isNull() ? plotPanel : -1))
+        {
+            continue;
+        }
+
+        // One scene transform per file, applied to whole point arrays
+        QTransform transform = file.transform * QTransform::fromTranslate(-origin.x(), -origin.y());
+        QRectF fileRect = file.rect.translated(-origin);
+        if (!clipRect.isNull() && !clipRect.intersects(fileRect))
+        {
+            continue;
+        }
+
+        // Files crossing the end of a length of roll are cut there
+        bool clip = !clipRect.isNull() && !clipRect.contains(fileRect);
+        QVector<QPolygon> objects;
+        QVector<int> objectItem;
+        int boxItem = file.cutout_box.isEmpty() ? -1 : file.geometry.length();
+        for (int i2 = 0; i2 < file.geometry.length() + (boxItem < 0 ? 0 : 1); ++i2)
+        {
+            const QPolygonF & polygon = (i2 == boxItem) ? file.cutout_box : file.geometry.at(i2);
+            QPolygon points;
+            if (!clip)
+            {
+                if (!hpglGeometry::mapToDevice(transform, polygon, points))
+                {
+                    emit statusUpdate("Object out of bounds in file " + QString::number(i+1) + ".", Qt::darkRed);
+                    return false;
+                }
+                objects.push_back(points);
+                objectItem.push_back(i2);
+                continue;
+            }
+            QVector<QPolygonF> pieces = hpglGeometry::clipPolyline(transform.map(polygon), clipRect);
+            for (int piece = 0; piece < pieces.length(); ++piece)
+            {
+                hpglGeometry::mapToDevice(QTransform(), pieces.at(piece), points);
+                objects.push_back(points);
+                objectItem.push_back(i2);
+            }
+        }
+
+        while (sharedEdges && !objects.isEmpty() && objectItem.last() == boxItem)
+        {
+            boxes.push_back(objects.takeLast());
+            objectItem.removeLast();
+        }
+        if (dedupEnabled)
+        {
+            QVector<QPolygon> unique;
+            QVector<int> uniqueItem;
+            for (int o = 0; o < objects.length(); ++o)
+            {
+                QVector<QPolygon> pieces = dedup.add(objects.at(o));
+                for (int piece = 0; piece < pieces.length(); ++piece)
+                {
+                    unique.push_back(pieces.at(piece));
+                    uniqueItem.push_back(objectItem.at(o));
+                }
+            }
+            objects = unique;
+            objectItem = uniqueItem;
+        }
+        encodeObjects(i, objects, objectItem, last_point, absoluteBytes, objectCount);
     }
 
-    index = hpglModel->index(hpglList_index);
-    hpglModel->dataItemsGroup(index, itemGroup, items);
+    if (!boxes.isEmpty())
+    {
+        encodeSharedEdges(boxes, last_point, absoluteBytes, objectCount);
+    }
 
-    if (itemGroup == NULL)
+    // Corner marks for lining the next length of roll up with this one
+    if (!clipRect.isNull() && settings.value("device/rolllength/marks", SETDEF_DEVICE_ROLLLENGTH_MARKS).toBool())
     {
-        qDebug() << "Error: itemgroup is null in do_plotnext().";
-        return;
+        QVector<QPolygon> marks;
+        QVector<int> markItem;
+        int right = clipRect.width();
+        int bottom = PLOT_MARK_INSET;
+        int top = clipRect.height() - PLOT_MARK_INSET;
+        marks << (QPolygon() << QPoint(PLOT_MARK_SIZE, bottom) << QPoint(0, bottom) << QPoint(0, bottom + PLOT_MARK_SIZE));
+        marks << (QPolygon() << QPoint(0, top - PLOT_MARK_SIZE) << QPoint(0, top) << QPoint(PLOT_MARK_SIZE, top));
+        marks << (QPolygon() << QPoint(right - PLOT_MARK_SIZE, top) << QPoint(right, top) << QPoint(right, top - PLOT_MARK_SIZE));
+        marks << (QPolygon() << QPoint(right, bottom + PLOT_MARK_SIZE) << QPoint(right, bottom) << QPoint(right - PLOT_MARK_SIZE, bottom));
+        for (int i = 0; i < marks.length(); ++i)
+        {
+            markItem.push_back(i);
+        }
+        encodeObjects(-1, marks, markItem, last_point, absoluteBytes, objectCount);
     }
-    if (items == NULL)
+
+    QString report = "Encoded " + QString::number(objectCount) + " objects as "
+            + QString::number(strokes.length()) + " strokes, "
+            + QString::number(jobStream.length()) + " bytes";
+    if (absoluteBytes > 0 && encoder.encoding() != ENCODING_ABSOLUTE)
     {
-        qDebug() << "Error: items is null in do_plotnext().";
-        return;
+        report += " (" + QString::number(100.0 * (absoluteBytes - jobStream.length()) / absoluteBytes, 'f', 1)
+                + "% smaller than absolute)";
+    }
+    report += ".";
+    emit statusUpdate(report);
+    if (dedupEnabled && dedup.removedLength() > 0)
+    {
+        emit statusUpdate("Removed " + QString::number(dedup.removedLength() * ETA_UNITS_TO_MM / 1000.0, 'f', 2)
+                          + "m of duplicate cuts (" + QString::number(dedup.removedSegments()) + " whole segments).");
     }
 
-    hpglModel->mutexLock();
+    return(!strokes.isEmpty());
+}
 
-    if (hpgl_obj_index >= items->length())
+/**
+ * @brief ExtPlot::encodeObjects
+ * Appends one file's objects, already in plotter units, to the job.
+ * @param file - model row, or -1 for registration marks
+ * @param objectItem - the item each object came from
+ */
+void ExtPlot::encodeObjects(int file, const QVector<QPolygon> & objects, const QVector<int> & objectItem,
+                            QPoint & last_point, qint64 & absoluteBytes, int & objectCount)
+{
+    int o = 0;
+    while (o < objects.length())
     {
-        hpglModel->mutexUnlock();
-        hpglList_index++;
-        hpgl_obj_index = 0;
-        do_plotNext();
-        return;
+        plot_stroke stroke;
+        QPolygon chain;
+        double time = 0;
+
+        stroke.file = file;
+        stroke.index = objectItem.at(o);
+        stroke.count = 0;
+        stroke.start = encoder.position();
+        stroke.cutLength = 0;
+        stroke.travelLength = 0;
+
+        // Collect this object plus any that continue from its end
+        while (o < objects.length())
+        {
+            const QPolygon & points = objects.at(o);
+            if (points.isEmpty() || (!chain.isEmpty() && points.first() != chain.last()))
+            {
+                break;
+            }
+            if (chain.isEmpty())
+            {
+                time += ExtEta::travelTime(QLineF(last_point, points.first()), motion);
+                stroke.travelLength = QLineF(last_point, points.first()).length() * ETA_UNITS_TO_MM;
+                chain = points;
+            }
+            else
+            {
+                chain += points.mid(1);
+            }
+            absoluteBytes += hpglEncoder::absoluteLength(points);
+            ++stroke.count;
+            ++objectCount;
+            ++o;
+        }
+
+        if (chain.isEmpty())
+        {
+            ++o; // empty object
+            continue;
+        }
+        last_point = chain.last();
+        time += ExtEta::strokeTime(QPolygonF(chain), motion);
+        stroke.cutLength = ExtEta::lenHyp(QPolygonF(chain));
+        stroke.segments = chain.length() - 1;
+
+        stroke.offset = jobStream.length();
+        stroke.time = time;
+        jobStream.append(encoder.stroke(chain));
+        stroke.length = jobStream.length() - stroke.offset;
+        strokes.push_back(stroke);
     }
-    index = hpglModel->index(hpglList_index);
-    if (cancelPlotFlag == true)
+}
+
+/**
+ * @brief ExtPlot::encodeSharedEdges
+ * Merges the cutout boxes' edges where they lie on top of each other and
+ * cuts them as a few long chains instead of one rectangle per file.
+ */
+void ExtPlot::encodeSharedEdges(const QVector<QPolygon> & boxes, QPoint & last_point,
+                                qint64 & absoluteBytes, int & objectCount)
+{
+    QVector<QLine> segments;
+    double beforeLength = 0, beforeTime = 0;
+    double afterLength = 0, afterTime = 0;
+
+    for (int i = 0; i < boxes.length(); ++i)
     {
-        hpglModel->mutexUnlock();
-        emit statusUpdate("Bailing out of plot, cancelled!", Qt::darkRed);
-        closeSerial();
-        emit finished();
-        return;
+        const QPolygon & box = boxes.at(i);
+        beforeLength += ExtEta::lenHyp(QPolygonF(box));
+        beforeTime += ExtEta::strokeTime(QPolygonF(box), motion);
+        for (int j = 1; j < box.count(); ++j)
+        {
+            segments.push_back(QLine(box.at(j-1), box.at(j)));
+        }
+    }
+
+    QVector<QLine> merged = hpglGeometry::mergeAxisSegments(segments, PLOT_SHARED_EDGE_TOLERANCE);
+    QVector<QPolygon> chains = hpglGeometry::chainSegments(merged, last_point);
+    QVector<int> chainItem;
+    for (int i = 0; i < chains.length(); ++i)
+    {
+        afterLength += ExtEta::lenHyp(QPolygonF(chains.at(i)));
+        afterTime += ExtEta::strokeTime(QPolygonF(chains.at(i)), motion);
+        chainItem.push_back(i);
+    }
+    encodeObjects(-1, chains, chainItem, last_point, absoluteBytes, objectCount);
+
+    emit statusUpdate("Cutout boxes: " + QString::number(boxes.length()) + " cut as "
+                      + QString::number(chains.length()) + " strokes, "
+                      + QString::number((beforeLength - afterLength) / 1000.0, 'f', 2) + " m less cutting, about "
+                      + QString::number(beforeTime - afterTime, 'f', 1) + " s saved.");
+}
+
+/**
+ * @brief ExtPlot::saveJob
+ * Writes the encoded stream and stroke table next to the checkpoint settings.
+ */
+bool ExtPlot::saveJob()
+{
+    QSaveFile file(checkpointPath());
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        emit statusUpdate("Couldn't write plot checkpoint file.", Qt::darkRed);
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << (quint32)PLOT_CHECKPOINT_MAGIC << (qint32)PLOT_CHECKPOINT_VERSION;
+    out << (qint32)encoder.encoding();
+    out << (qint32)strokes.length();
+    for (int i = 0; i < strokes.length(); ++i)
+    {
+        const plot_stroke & stroke = strokes.at(i);
+        out << (qint32)stroke.file << (qint32)stroke.index << (qint32)stroke.count
+            << stroke.start << (qint32)stroke.offset << (qint32)stroke.length << stroke.time
+            << stroke.cutLength << stroke.travelLength << (qint32)stroke.segments;
     }
+    out << jobStream;
 
-//    qDebug() << "Plotting file number: " << hpglList_index << ", object number: " << hpgl_obj_index;
-//    qDebug() << "Total file count: " << hpglList->count();
+    if (!file.commit())
+    {
+        emit statusUpdate("Couldn't write plot checkpoint file.", Qt::darkRed);
+        return false;
+    }
 
-    int progressPercent = (((double)hpglList_index+((double)hpgl_obj_index/(items->count()-1)))/(hpglModel->rowCount()))*100;
-    emit progress(progressPercent);
+    QSettings settings;
+    settings.setValue("plot/checkpoint", true);
+    settings.setValue("plot/checkpoint/stroke", 0);
+    settings.setValue("plot/checkpoint/file", 0);
+    settings.setValue("plot/checkpoint/offset", 0);
+    settings.setValue("plot/checkpoint/total", strokes.length());
+    return true;
+}
 
-    QString printThis = print(items->at(hpgl_obj_index)->polygon(),
-                              itemGroup);
+bool ExtPlot::loadJob()
+{
+    QFile file(checkpointPath());
+    quint32 magic;
+    qint32 version, count, encoding;
 
-    if (printThis == "OOB")
+    if (!hasCheckpoint() || !file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in >> magic >> version;
+    if (magic != PLOT_CHECKPOINT_MAGIC || version != PLOT_CHECKPOINT_VERSION)
+    {
+        qDebug() << "Plot checkpoint has unknown format: " << magic << version;
+        return false;
+    }
+
+    // The stream must be resumed with the encoding it was written in
+    in >> encoding;
+    if (encoding < 0 || encoding >= ENCODING_SIZE_OF_ENUM)
+    {
+        qDebug() << "Plot checkpoint has unknown encoding: " << encoding;
+        return false;
+    }
+    encoder = hpglEncoder(static_cast<deviceEncoding_t>(encoding));
+
+    in >> count;
+    strokes.clear();
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        plot_stroke stroke;
+        qint32 _file, _index, _count, _offset, _length, _segments;
+        in >> _file >> _index >> _count >> stroke.start >> _offset >> _length >> stroke.time
+           >> stroke.cutLength >> stroke.travelLength >> _segments;
+        stroke.file = _file;
+        stroke.index = _index;
+        stroke.count = _count;
+        stroke.offset = _offset;
+        stroke.length = _length;
+        stroke.segments = _segments;
+        strokes.push_back(stroke);
+    }
+    in >> jobStream;
+
+    if (in.status() != QDataStream::Ok || strokes.isEmpty()
+            || (strokes.last().offset + strokes.last().length) > jobStream.length())
+    {
+        qDebug() << "Plot checkpoint is truncated.";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief ExtPlot::saveCheckpoint
+ * Records the first stroke that may not have been plotted. Resuming can
+ * repeat a few strokes, but never skips one.
+ * @param force - write even if the last write was recent
+ */
+void ExtPlot::saveCheckpoint(bool force)
+{
+    if (runPerimeterFlag || strokes.isEmpty())
     {
-        hpglModel->mutexUnlock();
-        emit finished();
         return;
     }
+    if (!force && checkpointTimer.isValid()
+            && checkpointTimer.elapsed() < PLOT_CHECKPOINT_INTERVAL_MS)
+    {
+        return;
+    }
+    checkpointTimer.restart();
 
-    if (hpglList_index == (hpglModel->rowCount()-1) && hpgl_obj_index == (items->length()-1))
+    QSettings settings;
+    settings.setValue("plot/checkpoint/stroke", done_index);
+    if (done_index < strokes.length())
     {
-        printThis += "PU0,0;SP0;IN;"; // Ending commands
+        settings.setValue("plot/checkpoint/file", strokes.at(done_index).file);
+        settings.setValue("plot/checkpoint/offset", strokes.at(done_index).offset);
     }
+    else
+    {
+        settings.setValue("plot/checkpoint/offset", jobStream.length());
+    }
+}
 
-    _port->write(printThis.toStdString().c_str());
-    if (settings.value("device/incremental", SETDEF_DEVICE_INCREMENTAL).toBool())
+/**
+ * @brief ExtPlot::writeStream
+ * Queues bytes on the serial port, remembering where each stroke ends
+ * so bytesWritten() can tell which strokes the port has taken.
+ */
+void ExtPlot::writeStream(const char * data, qint64 length, int strokeIndex)
+{
+    _port->write(data, length);
+    bytesQueued += length;
+    if (strokeIndex >= 0)
     {
-        _port->flush();
-        time = ExtEta::plotTime(items->at(hpgl_obj_index)->polygon());
-        QLineF last_line;
-        last_line.setP1(last_point);
-        last_line.setP2(itemGroup->mapToScene(items->at(hpgl_obj_index)->polygon().first()));
-        time += ExtEta::plotTime(last_line);
-        last_point = itemGroup->mapToScene(items->at(hpgl_obj_index)->polygon().last());
+        strokeMarkers.enqueue(qMakePair(bytesQueued, strokeIndex));
     }
+}
 
-    hpglModel->mutexUnlock();
+/**
+ * @brief ExtPlot::do_plotNext
+ * Writes strokes until the serial buffer is full, or until the current
+ * stroke has to be paced out. Re-entered from bytesWritten and the pacing timer.
+ */
+void ExtPlot::do_plotNext()
+{
+    while (state == STREAMING)
+    {
+        if (pacingPending)
+        {
+            return;
+        }
+        if (incremental && _port->bytesToWrite() > 0)
+        {
+            return;
+        }
+        if (_port->bytesToWrite() >= PLOT_WRITE_WATERMARK)
+        {
+            return;
+        }
+
+        if (stroke_index >= strokes.length())
+        {
+            emit statusUpdate("No more hpgl files left to plot.");
+            state = DRAINING;
+            QByteArray trailer = encoder.end(); // Ending commands
+            writeStream(trailer.constData(), trailer.length());
+            break;
+        }
+
+        const plot_stroke & stroke = strokes.at(stroke_index);
 
-    ++hpgl_obj_index;
-    QTimer::singleShot(time*1000, this, SLOT(do_plotNext()));
+        writeStream(jobStream.constData() + stroke.offset, stroke.length, stroke_index);
+        ++stroke_index;
+
+        if (incremental && stroke.time > 0)
+        {
+            pacingPending = true;
+            pacingTimer->start(stroke.time*1000);
+        }
+    }
+
+    if (state == DRAINING && _port->bytesToWrite() == 0)
+    {
+        finishPlot();
+    }
 }
 
-QString ExtPlot::print(QPolygonF hpgl_poly, QGraphicsItemGroup * itemGroup)
+void ExtPlot::handle_bytesWritten(qint64 bytes)
 {
-    QString retval = "";
-    QPointF point;
+    bytesSent += bytes;
+    int firstAcked = ack_index;
+    while (!strokeMarkers.isEmpty() && strokeMarkers.head().first <= bytesSent)
+    {
+        ackedMarkers.enqueue(strokeMarkers.head());
+        ack_index = strokeMarkers.dequeue().second + 1;
+    }
+    if (ack_index > firstAcked)
+    {
+        logAcked(firstAcked, ack_index);
+    }
+    // The driver taking a stroke doesn't mean it's been plotted: anything
+    // within deviceBuffer bytes of the latest write may still be queued
+    // in the OS, the port or the device.
+    while (!ackedMarkers.isEmpty() && ackedMarkers.head().first <= (bytesSent - deviceBuffer))
+    {
+        done_index = ackedMarkers.dequeue().second + 1;
+        drainTimer->stop(); // it was timing a stroke that's now counted
+    }
 
-    // Create PU command
-    point = itemGroup->mapToScene(hpgl_poly.first());
-    retval += "PU";
-    retval += QString::number(static_cast<int>(point.x()));
-    retval += ",";
-    retval += QString::number(static_cast<int>(point.y()));
-    retval += ";";
+    if (state == STREAMING)
+    {
+        saveCheckpoint(false);
+        do_plotNext();
+    }
+    else if (state == DRAINING && _port->bytesToWrite() == 0)
+    {
+        finishPlot();
+    }
 
-    // Create PD command
-    retval += "PD";
-    for (int idx = 1; idx < hpgl_poly.count(); idx++)
+    // Nothing more is coming to push the rest out by bytes
+    if ((state == STREAMING || state == PAUSED) && _port->bytesToWrite() == 0)
     {
-        point = itemGroup->mapToScene(hpgl_poly.at(idx));
+        startDrain();
+    }
+}
 
-        if (point.x() < 0 || point.y() < 0)
+/**
+ * @brief ExtPlot::startDrain
+ * With the serial driver empty, the strokes it has taken but that may
+ * still be buffered further on are counted as plotted one at a time,
+ * each once its expected time (with slack) has passed.
+ */
+void ExtPlot::startDrain()
+{
+    if (drainTimer->isActive())
+    {
+        return;
+    }
+    if (ackedMarkers.isEmpty())
+    {
+        if (state == PAUSED)
         {
-        retval = "OOB"; // Out of Bounds
-        return retval;
+            saveCheckpoint(true);
+            emit statusUpdate("Paused at stroke " + QString::number(done_index) + ", device drained.");
         }
+        return;
+    }
+    drainTimer->start(qCeil(strokes.at(ackedMarkers.head().second).time * 1000.0 * PLOT_DRAIN_SLACK));
+}
 
-        retval += QString::number(static_cast<int>(point.x()));
-        retval += ",";
-        retval += QString::number(static_cast<int>(point.y()));
-        if (idx < (hpgl_poly.length()-1))
+void ExtPlot::handle_drainTimeout()
+{
+    if (ackedMarkers.isEmpty())
+    {
+        return;
+    }
+    done_index = ackedMarkers.dequeue().second + 1;
+    if (state == STREAMING)
+    {
+        saveCheckpoint(false);
+    }
+    if (state == STREAMING || state == PAUSED)
+    {
+        startDrain();
+    }
+}
+
+void ExtPlot::handle_readyRead()
+{
+    // Devices only answer output instructions, which we don't send yet,
+    // so whatever arrives is discarded rather than left to fill the buffer.
+    _port->readAll();
+}
+
+void ExtPlot::handle_pacingTimeout()
+{
+    pacingPending = false;
+    do_plotNext();
+}
+
+/**
+ * @brief ExtPlot::handle_reportTimeout
+ * Progress by expected time of the strokes the port has taken, at a
+ * fixed rate rather than per stroke.
+ */
+void ExtPlot::handle_reportTimeout()
+{
+    if (strokes.isEmpty())
+    {
+        return;
+    }
+
+    double total = timeBefore.last();
+    double done = timeBefore.at(qBound(0, ack_index, strokes.length()));
+    double rate = (bytesSent - reportBytes) * (1000.0 / PLOT_REPORT_INTERVAL_MS);
+
+    reportBytes = bytesSent;
+    throughput = (throughput * 0.75) + (rate * 0.25); // smooth out serial bursts
+
+    emit progress(total > 0 ? (int)((100.0 * done) / total) : 0);
+    emit plotStatus(bytesSent, bytesTotal, throughput, total - done);
+}
+
+void ExtPlot::finishPlot()
+{
+    reportTimer->stop();
+    drainTimer->stop();
+    if (state == CANCELLED)
+    {
+        saveCheckpoint(true);
+    }
+    else
+    {
+        if (!runPerimeterFlag)
         {
-            retval += ",";
+            clearCheckpoint();
         }
+        state = IDLE;
+    }
+    if (sessionLog != NULL)
+    {
+        sessionLog->close();
+        delete sessionLog;
+        sessionLog = NULL;
+    }
+    closeSerial();
+    emit finished();
+}
+
+/**
+ * @brief ExtPlot::openSessionLog
+ * Starts a CSV record of how long the device took for each group of strokes,
+ * which ExtEta::calibrate() fits the motion model to. Only the newest logs
+ * are kept, older sessions are deleted to make room.
+ */
+void ExtPlot::openSessionLog()
+{
+    QSettings settings;
+
+    lastAckTime = -1;
+    if (!settings.value("device/sessionlog", SETDEF_DEVICE_SESSIONLOG).toBool())
+    {
+        return;
+    }
+
+    // Names sort oldest first
+    QDir dir(ExtEta::sessionLogDir());
+    QStringList logs = dir.entryList(QStringList() << "*.csv", QDir::Files, QDir::Name);
+    int keep = qMax(1, settings.value("device/sessionlog/keep", SETDEF_DEVICE_SESSIONLOG_KEEP).toInt());
+    for (int i = 0; i <= (logs.length() - keep); ++i)
+    {
+        dir.remove(logs.at(i));
+    }
+
+    sessionLog = new QFile(ExtEta::sessionLogDir() + "/"
+                           + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".csv");
+    if (!sessionLog->open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qDebug() << "Couldn't open session log: " << sessionLog->fileName();
+        delete sessionLog;
+        sessionLog = NULL;
+        return;
+    }
+
+    // Nominal speeds, without any calibrated profile applied
+    QTextStream out(sessionLog);
+    out << "# port: " << ExtEta::profileKey() << "\n";
+    out << "# baud: " << settings.value("serial/baud", SETDEF_SERIAL_BAUD).toInt() << "\n";
+    out << "# xonxoff: " << settings.value("serial/xonxoff", SETDEF_SERIAL_XONOFF).toInt() << "\n";
+    out << "# rtscts: " << settings.value("serial/rtscts", SETDEF_SERIAL_RTSCTS).toInt() << "\n";
+    out << "# incremental: " << (incremental ? 1 : 0) << "\n";
+    out << "# encoding: " << deviceEncoding_names[encoder.encoding()] << "\n";
+    out << "# cutspeed: " << ExtEta::speedTranslate(settings.value("device/speed/cut", SETDEF_DEVICE_SPEED_CUT).toInt()) << "\n";
+    out << "# travelspeed: " << ExtEta::speedTranslate(settings.value("device/speed/travel", SETDEF_DEVICE_SPEED_TRAVEL).toInt()) << "\n";
+    out << "strokes,cut_mm,travel_mm,segments,seconds,stalled\n";
+    sessionTimer.start();
+}
+
+/**
+ * @brief ExtPlot::logAcked
+ * Logs strokes [first, last) taken by the serial port in one bytesWritten().
+ * The time since the previous ack is only the device's time if the port
+ * was still backed up, which the stalled column records.
+ */
+void ExtPlot::logAcked(int first, int last)
+{
+    if (sessionLog == NULL)
+    {
+        return;
     }
-    retval += ";";
 
-    return(retval);
+    qint64 now = sessionTimer.elapsed();
+    if (lastAckTime >= 0)
+    {
+        double cut = 0, travel = 0;
+        int segments = 0;
+        for (int i = first; i < last && i < strokes.length(); ++i)
+        {
+            cut += strokes.at(i).cutLength;
+            travel += strokes.at(i).travelLength;
+            segments += strokes.at(i).segments;
+        }
+        QTextStream out(sessionLog);
+        out << (last - first) << "," << cut << "," << travel << "," << segments << ","
+            << (now - lastAckTime) / 1000.0 << "," << (_port->bytesToWrite() > 0 ? 1 : 0) << "\n";
+    }
+    lastAckTime = now;
 }
 
 void ExtPlot::statusUpdate(QString _consoleStatus)
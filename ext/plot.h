@@ -12,10 +12,48 @@
 #include <QGraphicsPolygonItem>
 #include <QVector>
 #include <QtMath>
+#include <QTimer>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QStandardPaths>
 
 #include "settings.h"
 #include "hpgllistmodel.h"
 #include "eta.h"
+#include "encoder.h"
+#include "geometry.h"
+#include "dedup.h"
+
+// Bytes kept queued in the serial driver when not pacing strokes
+#define PLOT_WRITE_WATERMARK (4096)
+// Minimum time between checkpoint writes while streaming
+#define PLOT_CHECKPOINT_INTERVAL_MS (1000)
+// Stroke times are estimates, so buffered strokes are waited out this much longer
+#define PLOT_DRAIN_SLACK (1.5)
+// Time between progress reports while streaming
+#define PLOT_REPORT_INTERVAL_MS (250)
+// Registration marks on lengths of roll
+#define PLOT_MARK_SIZE (400)    // 10mm arms
+#define PLOT_MARK_INSET (400)   // from the edges of the vinyl
+// Cutout box edges this close are cut as one
+#define PLOT_SHARED_EDGE_TOLERANCE (2)
+#define PLOT_CHECKPOINT_MAGIC (0x4C504350) // "LPCP"
+#define PLOT_CHECKPOINT_VERSION (3)
+
+// A single encoded stroke within the job stream
+struct plot_stroke {
+    int file;       // model row
+    int index;      // first object within the file
+    int count;      // chained objects merged into this stroke
+    QPoint start;   // pen position before the stroke
+    int offset;     // byte offset into the job stream
+    int length;     // encoded length in bytes
+    double time;    // expected plotting time in seconds
+    double cutLength;    // pen down length in mm
+    double travelLength; // pen up length in mm, from the previous stroke
+    int segments;   // pen down segments
+};
 
 namespace std {
 class ExtPlot;
@@ -30,36 +68,111 @@ public:
     ExtPlot(hpglListModel * model, QRectF _perimeter);
     ~ExtPlot();
 
+    /**
+     * Plot engine states, driven by serial port events.
+     * CONNECTING -> STREAMING <-> PAUSED
+     * STREAMING -> DRAINING -> (closed)
+     * Any state may move to CANCELLED.
+     */
+    enum plotState_t {
+        IDLE = 0,
+        CONNECTING,
+        STREAMING,
+        DRAINING,
+        PAUSED,
+        CANCELLED
+    };
+
+    void setResumeFromCheckpoint(bool resume);
+    void setPanel(int panel);
+    static bool hasCheckpoint();
+    static QString checkpointPath();
+    static void clearCheckpoint();
+
 public slots:
     void process();
     void cancel();
+    void pause();
+    void resume();
 
 private slots:
     void do_plotNext();
 //    void do_jogPerimeter();
-    QString print(QPolygonF hpgl_poly, QGraphicsItemGroup * itemGroup);
+    void handle_bytesWritten(qint64 bytes);
+    void handle_readyRead();
+    void handle_pacingTimeout();
+    void handle_drainTimeout();
+    void handle_reportTimeout();
 
 signals:
     void finished();
     void progress(int percent);
+    void plotStatus(qint64 bytesSent, qint64 bytesTotal, double bytesPerSecond, double secondsRemaining);
     void serialOpened();
     void serialClosed();
     void statusUpdate(QString text, QColor textColor);
 
 private:
     void statusUpdate(QString _consoleStatus);
+    bool encodeJob();
+    void encodeObjects(int file, const QVector<QPolygon> & objects, const QVector<int> & objectItem,
+                       QPoint & last_point, qint64 & absoluteBytes, int & objectCount);
+    void encodeSharedEdges(const QVector<QPolygon> & boxes, QPoint & last_point,
+                           qint64 & absoluteBytes, int & objectCount);
+    bool saveJob();
+    bool loadJob();
+    void saveCheckpoint(bool force);
+    void startDrain();
+    void writeStream(const char * data, qint64 length, int strokeIndex = -1);
+    void finishPlot();
+    void openSessionLog();
+    void logAcked(int first, int last);
 
     QPointer<QSerialPort> openSerial();
     void closeSerial();
-    bool cancelPlotFlag;
     bool runPerimeterFlag;
+    bool resumeFlag;
+    int plotPanel;          // -1 for the roll
     QRectF perimeterRect;
 
     // plotting
+    plotState_t state;
     QPointer<QSerialPort> _port;
+    QTimer * pacingTimer;
+    QTimer * drainTimer;    // counts buffered strokes as plotted once the port is empty
+    bool pacingPending;
     hpglListModel * hpglModel;
-    int hpglList_index, hpgl_obj_index;
-    QPointF last_point;
+
+    // pre-encoded job
+    hpglEncoder encoder;
+    QByteArray jobStream;
+    QVector<plot_stroke> strokes;
+    int stroke_index;       // next stroke to write
+    int ack_index;          // first stroke not yet taken by the serial port
+    int done_index;         // first stroke that may not have been plotted, checkpointed
+
+    // serial acknowledgement tracking
+    qint64 bytesQueued, bytesSent;
+    QQueue<QPair<qint64, int> > strokeMarkers;
+    QQueue<QPair<qint64, int> > ackedMarkers;  // taken by the port, maybe still buffered
+    qint64 deviceBuffer;    // bytes that can be in flight after bytesWritten()
+    QElapsedTimer checkpointTimer;
+
+    // progress reporting, weighted by expected stroke time
+    QTimer * reportTimer;
+    QVector<double> timeBefore; // expected time of all strokes before each one
+    qint64 bytesTotal;
+    qint64 reportBytes;
+    double throughput;
+
+    // session log, for calibrating the ETA against this device
+    QFile * sessionLog;
+    QElapsedTimer sessionTimer;
+    qint64 lastAckTime;     // -1 when the next ack follows a gap (start, pause)
+
+    // settings, read once per job
+    bool incremental;
+    eta_motion motion;
 };
 
 #endif // EXTPLOT_H
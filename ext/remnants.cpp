@@ -0,0 +1,105 @@
+/**
+ * hpglRemnants - offcut inventory
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "remnants.h"
+
+QVector<remnant_piece> hpglRemnants::load()
+{
+    QSettings settings;
+    QVector<remnant_piece> pieces;
+
+    int count = settings.beginReadArray("remnants");
+    for (int i = 0; i < count; ++i)
+    {
+        settings.setArrayIndex(i);
+        remnant_piece piece;
+        piece.name = settings.value("name").toString();
+        piece.outline = settings.value("outline").value<QPolygonF>();
+        if (piece.outline.length() < 3)
+        {
+            qDebug() << "Skipping remnant without an outline:" << piece.name;
+            continue;
+        }
+        pieces.push_back(piece);
+    }
+    settings.endArray();
+    return(pieces);
+}
+
+void hpglRemnants::save(const QVector<remnant_piece> & pieces)
+{
+    QSettings settings;
+
+    settings.remove("remnants");
+    settings.beginWriteArray("remnants", pieces.length());
+    for (int i = 0; i < pieces.length(); ++i)
+    {
+        settings.setArrayIndex(i);
+        settings.setValue("name", pieces.at(i).name);
+        settings.setValue("outline", QVariant::fromValue(pieces.at(i).outline));
+    }
+    settings.endArray();
+}
+
+void hpglRemnants::add(const remnant_piece & piece)
+{
+    QVector<remnant_piece> pieces = load();
+    pieces.push_back(piece);
+    save(pieces);
+}
+
+void hpglRemnants::remove(int piece)
+{
+    QVector<remnant_piece> pieces = load();
+    if (piece < 0 || piece >= pieces.length())
+    {
+        return;
+    }
+    pieces.remove(piece);
+    save(pieces);
+}
+
+/**
+ * @brief hpglRemnants::freeSpace
+ * Free space for packing into an outline, with its bounding box at the
+ * origin. The outline is cut into bands and whatever lies outside it in
+ * each band is taken, so only rectangles wholly inside the piece fit.
+ */
+hpglFreeSpace hpglRemnants::freeSpace(const QPolygonF & outline)
+{
+    QRectF bounds = outline.boundingRect();
+    QPolygonF shape = outline.translated(-bounds.topLeft());
+    QPainterPath path;
+    hpglFreeSpace space(bounds.width(), bounds.height());
+
+    path.addPolygon(shape);
+    path.closeSubpath();
+
+    for (double y = 0; y < bounds.height(); y += REMNANT_BAND)
+    {
+        QPainterPath band, outside;
+        band.addRect(QRectF(0, y, bounds.width(), qMin((double)REMNANT_BAND, bounds.height() - y)));
+        outside = band.subtracted(path);
+
+        QList<QPolygonF> pieces = outside.toFillPolygons();
+        for (int i = 0; i < pieces.length(); ++i)
+        {
+            space.occupy(pieces.at(i).boundingRect());
+        }
+    }
+    return(space);
+}
+
+// Shoelace formula, in square plotter units
+double hpglRemnants::area(const QPolygonF & outline)
+{
+    double sum = 0;
+    for (int i = 0; i < outline.length(); ++i)
+    {
+        const QPointF & a = outline.at(i);
+        const QPointF & b = outline.at((i+1) % outline.length());
+        sum += (a.x() * b.y()) - (b.x() * a.y());
+    }
+    return(qFabs(sum) / 2.0);
+}
@@ -0,0 +1,46 @@
+/**
+ * hpglRemnants - offcut inventory header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLREMNANTS_H
+#define HPGLREMNANTS_H
+
+#include <QtCore>
+#include <QVector>
+#include <QPolygonF>
+#include <QPainterPath>
+#include <QtMath>
+
+#include "settings.h"
+#include "freespace.h"
+
+// Height of the bands an irregular outline is cut into for packing
+#define REMNANT_BAND (254) // 1/4"
+
+// One offcut, in plotter units with x across the roll and y along it
+struct remnant_piece {
+    QString name;
+    QPolygonF outline;
+};
+
+namespace std {
+class hpglRemnants;
+}
+
+/**
+ * @brief The hpglRemnants class
+ * The inventory of leftover pieces of vinyl, kept in the settings so it
+ * lasts between jobs.
+ */
+class hpglRemnants
+{
+public:
+    static QVector<remnant_piece> load();
+    static void save(const QVector<remnant_piece> & pieces);
+    static void add(const remnant_piece & piece);
+    static void remove(int piece);
+    static hpglFreeSpace freeSpace(const QPolygonF & outline);
+    static double area(const QPolygonF & outline);
+};
+
+#endif // HPGLREMNANTS_H
@@ -0,0 +1,79 @@
+/**
+ * hpglRollSplitter - splitting a layout into lengths of roll
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "rollsplit.h"
+
+/**
+ * @brief hpglRollSplitter::split
+ * Panels run from the origin to the end of the last file. With tiling the
+ * cuts are a roll length apart and files crossing them are cut in two.
+ * Without it each cut is pulled back to the start of any file it would
+ * cross, so only files longer than a roll are cut.
+ * @param files - scene bounding rects of the files on the roll
+ * @param tiled - set to the number of files that are cut
+ */
+QVector<hpgl_panel> hpglRollSplitter::split(const QVector<QRectF> & files, double width,
+                                            double rollLength, bool tile, int * tiled)
+{
+    QVector<hpgl_panel> panels;
+    double jobEnd = 0;
+    double start = 0;
+
+    for (int i = 0; i < files.length(); ++i)
+    {
+        jobEnd = qMax(jobEnd, files.at(i).right());
+    }
+
+    while (start < jobEnd && rollLength > 0)
+    {
+        double end = start + rollLength;
+
+        if (!tile && end < jobEnd)
+        {
+            bool moved = true;
+            while (moved)
+            {
+                moved = false;
+                for (int i = 0; i < files.length(); ++i)
+                {
+                    const QRectF & file = files.at(i);
+                    if (file.left() > start && file.left() < end && file.right() > end)
+                    {
+                        end = file.left();
+                        moved = true;
+                    }
+                }
+            }
+        }
+
+        hpgl_panel panel;
+        panel.name = "Roll " + QString::number(panels.length() + 1);
+        panel.rect = QRectF(start, 0, qMin(end, jobEnd) - start, width);
+        panel.outline = QPolygonF(panel.rect);
+        panel.roll = true;
+        panels.push_back(panel);
+        start = end;
+    }
+
+    if (tiled != NULL)
+    {
+        *tiled = 0;
+        for (int i = 0; i < files.length(); ++i)
+        {
+            int count = 0;
+            for (int j = 0; j < panels.length(); ++j)
+            {
+                if (panels.at(j).rect.intersects(files.at(i)))
+                {
+                    ++count;
+                }
+            }
+            if (count > 1)
+            {
+                ++(*tiled);
+            }
+        }
+    }
+    return(panels);
+}
@@ -0,0 +1,30 @@
+/**
+ * hpglRollSplitter - splitting a layout into lengths of roll header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLROLLSPLITTER_H
+#define HPGLROLLSPLITTER_H
+
+#include <QtCore>
+#include <QVector>
+#include <QRectF>
+
+#include "hpgllistmodel.h"
+
+namespace std {
+class hpglRollSplitter;
+}
+
+/**
+ * @brief The hpglRollSplitter class
+ * Cuts a layout that's longer than a roll into roll panels, in scene
+ * coordinates, without moving any files.
+ */
+class hpglRollSplitter
+{
+public:
+    static QVector<hpgl_panel> split(const QVector<QRectF> & files, double width,
+                                     double rollLength, bool tile, int * tiled);
+};
+
+#endif // HPGLROLLSPLITTER_H
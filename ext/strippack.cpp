@@ -0,0 +1,228 @@
+/**
+ * hpglStripPacker - open ended strip packing
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include "strippack.h"
+
+#include <algorithm>
+
+hpglStripPacker::hpglStripPacker(int width)
+{
+    stripWidth = width;
+    searchIterations = 0;
+}
+
+bool hpglStripPacker::pack(const QVector<QSizeF> & sizes, const QVector<int> & order,
+                           QVector<QRectF> & rects, double & length)
+{
+    return pack(sizes, order, QVector<char>(), rects, length);
+}
+
+/**
+ * @brief hpglStripPacker::pack
+ * One bottom-left skyline pass in the given order.
+ * @param turns - stripTurn_t per input size, or empty to choose every one
+ * @param rects - set per input size, not per order
+ * @param length - set to the strip length used
+ * @return - false if something can't fit across the strip
+ */
+bool hpglStripPacker::pack(const QVector<QSizeF> & sizes, const QVector<int> & order, const QVector<char> & turns,
+                           QVector<QRectF> & rects, double & length)
+{
+    skyline_node start = {0, 0, stripWidth};
+
+    skyline.clear();
+    skyline.push_back(start);
+    rects.resize(sizes.length());
+    length = 0;
+
+    for (int i = 0; i < order.length(); ++i)
+    {
+        int file = order.at(i);
+        int width = qCeil(sizes.at(file).width());
+        int height = qCeil(sizes.at(file).height());
+        int x, y, node, turnedX, turnedY, turnedNode;
+
+        int turn = turns.isEmpty() ? TURN_ANY : turns.at(file);
+        bool upright = (turn != TURN_TURNED) && findPosition(width, height, x, y, node);
+        bool turned = (turn != TURN_UPRIGHT) && findPosition(height, width, turnedX, turnedY, turnedNode);
+        if (!upright && !turned)
+        {
+            return false;
+        }
+
+        // Lowest top edge, then furthest left
+        if (!upright || (turned && ((turnedY + width) < (y + height)
+                                    || ((turnedY + width) == (y + height) && turnedX < x))))
+        {
+            qSwap(width, height);
+            x = turnedX;
+            y = turnedY;
+            node = turnedNode;
+        }
+
+        place(node, x, y, width, height);
+        rects[file] = QRectF(x, y, width, height);
+        length = qMax(length, (double)(y + height));
+    }
+    return true;
+}
+
+/**
+ * @brief hpglStripPacker::optimize
+ * Starts from the longest side first order and keeps swapping pairs of
+ * rectangles for as long as allowed, keeping any order that isn't longer.
+ */
+bool hpglStripPacker::optimize(const QVector<QSizeF> & sizes, qint64 msecs,
+                               QVector<QRectF> & rects, double & length)
+{
+    QElapsedTimer timer;
+    QVector<int> order, trial;
+    QVector<QRectF> trialRects;
+    double trialLength;
+    quint32 seed = 2463534242u;
+
+    timer.start();
+    searchIterations = 0;
+
+    order = longestSideOrder(sizes);
+
+    if (!pack(sizes, order, rects, length))
+    {
+        return false;
+    }
+
+    while (order.length() > 1 && timer.elapsed() < msecs)
+    {
+        // xorshift32, cheap and the same on every run
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        int a = seed % order.length();
+        int b = (seed / order.length()) % order.length();
+        if (a == b)
+        {
+            continue;
+        }
+
+        trial = order;
+        qSwap(trial[a], trial[b]);
+        ++searchIterations;
+        if (pack(sizes, trial, trialRects, trialLength) && trialLength <= length)
+        {
+            order = trial;
+            rects = trialRects;
+            length = trialLength;
+        }
+    }
+    return true;
+}
+
+QVector<int> hpglStripPacker::longestSideOrder(const QVector<QSizeF> & sizes)
+{
+    QVector<QPair<double, int> > keyed;
+    QVector<int> order;
+
+    for (int i = 0; i < sizes.length(); ++i)
+    {
+        double longest = qMax(sizes.at(i).width(), sizes.at(i).height());
+        keyed.push_back(qMakePair(-longest, i));
+    }
+    std::stable_sort(keyed.begin(), keyed.end());
+    for (int i = 0; i < keyed.length(); ++i)
+    {
+        order.push_back(keyed.at(i).second);
+    }
+    return(order);
+}
+
+int hpglStripPacker::iterations()
+{
+    return(searchIterations);
+}
+
+/**
+ * @brief hpglStripPacker::findPosition
+ * Best node to put a width x height rectangle's left edge on.
+ */
+bool hpglStripPacker::findPosition(int width, int height, int & bestX, int & bestY, int & bestNode)
+{
+    int bestTop = INT_MAX;
+
+    bestNode = -1;
+    for (int i = 0; i < skyline.length(); ++i)
+    {
+        int y = fitAt(i, width);
+        if (y < 0)
+        {
+            continue;
+        }
+        if ((y + height) < bestTop || ((y + height) == bestTop && skyline.at(i).x < bestX))
+        {
+            bestTop = y + height;
+            bestX = skyline.at(i).x;
+            bestY = y;
+            bestNode = i;
+        }
+    }
+    return(bestNode >= 0);
+}
+
+/**
+ * @brief hpglStripPacker::fitAt
+ * @return - the lowest y a rectangle starting at node can sit at, or -1 if it sticks out the side
+ */
+int hpglStripPacker::fitAt(int node, int width)
+{
+    int x = skyline.at(node).x;
+    int y = 0;
+    int remaining = width;
+
+    if ((x + width) > stripWidth)
+    {
+        return -1;
+    }
+    while (remaining > 0)
+    {
+        y = qMax(y, skyline.at(node).y);
+        remaining -= skyline.at(node).width;
+        ++node;
+    }
+    return(y);
+}
+
+void hpglStripPacker::place(int node, int x, int y, int width, int height)
+{
+    skyline_node added = {x, y + height, width};
+    skyline.insert(node, added);
+
+    // Trim what the new node covers
+    for (int i = node+1; i < skyline.length(); ++i)
+    {
+        int right = skyline.at(node).x + skyline.at(node).width;
+        if (skyline.at(i).x >= right)
+        {
+            break;
+        }
+        int shrink = right - skyline.at(i).x;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline.at(i).width > 0)
+        {
+            break;
+        }
+        skyline.remove(i);
+        --i;
+    }
+
+    // Merge neighbours at the same height
+    for (int i = 0; i < (skyline.length() - 1); ++i)
+    {
+        if (skyline.at(i).y == skyline.at(i+1).y)
+        {
+            skyline[i].width += skyline.at(i+1).width;
+            skyline.remove(i+1);
+            --i;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/**
+ * hpglStripPacker - open ended strip packing header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLSTRIPPACKER_H
+#define HPGLSTRIPPACKER_H
+
+#include <QtCore>
+#include <QVector>
+#include <QRectF>
+#include <QSizeF>
+#include <QtMath>
+#include <climits>
+
+namespace std {
+class hpglStripPacker;
+}
+
+/**
+ * @brief The hpglStripPacker class
+ * Packs rectangles into a strip of fixed width and unlimited length with
+ * a bottom-left skyline, then searches orderings for a shorter strip.
+ * Like rbp's packers, x is across the strip and rectangles may be turned.
+ */
+class hpglStripPacker
+{
+public:
+    hpglStripPacker(int width);
+
+    // Orientation choices for pack()
+    enum stripTurn_t {
+        TURN_ANY = 0,
+        TURN_UPRIGHT,
+        TURN_TURNED
+    };
+
+    bool pack(const QVector<QSizeF> & sizes, const QVector<int> & order,
+              QVector<QRectF> & rects, double & length);
+    bool pack(const QVector<QSizeF> & sizes, const QVector<int> & order, const QVector<char> & turns,
+              QVector<QRectF> & rects, double & length);
+    static QVector<int> longestSideOrder(const QVector<QSizeF> & sizes);
+    bool optimize(const QVector<QSizeF> & sizes, qint64 msecs,
+                  QVector<QRectF> & rects, double & length);
+    int iterations();
+
+private:
+    struct skyline_node {
+        int x;
+        int y;
+        int width;
+    };
+
+    bool findPosition(int width, int height, int & bestX, int & bestY, int & bestNode);
+    int fitAt(int node, int width);
+    void place(int node, int x, int y, int width, int height);
+
+    int stripWidth;
+    int searchIterations;
+    QVector<skyline_node> skyline;
+};
+
+#endif // HPGLSTRIPPACKER_H
@@ -0,0 +1,81 @@
+#include "hpglfileitem.h"
+
+hpglFileItem::hpglFileItem(QGraphicsItem * parent)
+    :QAbstractGraphicsShapeItem(parent)
+{
+}
+
+/**
+ * @brief hpglFileItem::addStroke
+ * Strokes are open polylines, so they're added without closing them.
+ */
+void hpglFileItem::addStroke(const QPolygonF & stroke)
+{
+    if (stroke.isEmpty())
+    {
+        return;
+    }
+    prepareGeometryChange();
+    artwork.addPolygon(stroke);
+    artworkBounds = artworkBounds.united(stroke.boundingRect());
+    updateBounds();
+}
+
+/**
+ * @brief hpglFileItem::shareArtwork
+ * Paints the same path as another file's item, without copying it.
+ */
+void hpglFileItem::shareArtwork(const hpglFileItem & source)
+{
+    prepareGeometryChange();
+    artwork = source.artwork;
+    artworkBounds = source.artworkBounds;
+    updateBounds();
+}
+
+/**
+ * @brief hpglFileItem::setCutoutBox
+ * @param box - item coordinates, empty to remove it
+ */
+void hpglFileItem::setCutoutBox(const QPolygonF & box)
+{
+    prepareGeometryChange();
+    cutoutBox = box;
+    updateBounds();
+}
+
+void hpglFileItem::updateBounds()
+{
+    bounds = artworkBounds.united(cutoutBox.boundingRect());
+}
+
+int hpglFileItem::type() const
+{
+    return(Type);
+}
+
+QRectF hpglFileItem::boundingRect() const
+{
+    qreal half = pen().widthF() / 2.0;
+    return(bounds.adjusted(-half, -half, half, half));
+}
+
+void hpglFileItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
+{
+    Q_UNUSED(widget);
+
+    painter->setPen(pen());
+    painter->setBrush(brush());
+    painter->drawPath(artwork);
+    if (!cutoutBox.isEmpty())
+    {
+        painter->drawPolyline(cutoutBox);
+    }
+
+    if (option->state & QStyle::State_Selected)
+    {
+        painter->setPen(QPen(option->palette.windowText(), 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(bounds);
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * HPGL File Item - header
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#ifndef HPGLFILEITEM_H
+#define HPGLFILEITEM_H
+
+#include <QtCore>
+#include <QAbstractGraphicsShapeItem>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QStyle>
+#include <QStyleOptionGraphicsItem>
+
+namespace std {
+class hpglFileItem;
+}
+
+/**
+ * @brief The hpglFileItem class
+ * One scene item per file: every stroke, painted from a single path, and
+ * the cutout box. The path is implicitly shared, so duplicates of a file
+ * paint the same path under their own transforms. The bounding rect is
+ * kept as strokes are added rather than measured.
+ */
+class hpglFileItem : public QAbstractGraphicsShapeItem
+{
+public:
+    enum { Type = UserType + 1 };
+
+    explicit hpglFileItem(QGraphicsItem * parent = 0);
+
+    void addStroke(const QPolygonF & stroke);
+    void shareArtwork(const hpglFileItem & source);
+    void setCutoutBox(const QPolygonF & box);
+
+    int type() const;
+    QRectF boundingRect() const;
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = 0);
+
+private:
+    void updateBounds();
+
+    QPainterPath artwork;
+    QRectF artworkBounds;   // kept as strokes are added
+    QPolygonF cutoutBox;    // item coordinates, empty without one
+    QRectF bounds;          // artwork and box together
+};
+
+#endif // HPGLFILEITEM_H
@@ -133,12 +133,12 @@ void hpglGraphicsView::zoomGraphicsItems()
     newrect.setHeight(0);
 
     QList<QGraphicsItem*> itemList = items();
-    // type() = 10 -> QGraphicsItemGroup
+    // One hpglFileItem per file
 
     for (int i = 0; i < itemList.length(); ++i)
     {
         QGraphicsItem * item = itemList.at(i);
-        if (item->type() == 10) // item is a qgraphicsitemgroup
+        if (item->type() == hpglFileItem::Type)
         {
             QRectF compRect = item->boundingRect();
             QPointF compPoint = item->pos();
@@ -171,12 +171,12 @@ void hpglGraphicsView::zoomSelectedItems()
     newrect.setHeight(0);
 
     QList<QGraphicsItem*> itemList = items();
-    // type() = 10 -> QGraphicsItemGroup
+    // One hpglFileItem per file
 
     for (int i = 0; i < itemList.length(); ++i)
     {
         QGraphicsItem * item = itemList.at(i);
-        if (item->type() == 10 && item->isSelected()) // item is a qgraphicsitemgroup
+        if (item->type() == hpglFileItem::Type && item->isSelected())
         {
             QRectF compRect = item->boundingRect();
             QPointF compPoint = item->pos();
@@ -11,9 +11,9 @@
 #include <QMouseEvent>
 #include <QTransform>
 #include <QGraphicsItem>
-#include <QGraphicsItemGroup>
 
 #include "settings.h"
+#include "hpglfileitem.h"
 
 namespace std {
 class hpglGraphicsView;
@@ -1,5 +1,7 @@
 #include "hpgllistmodel.h"
 
+#include <algorithm>
+
 bool operator==(const file_uid& lhs, const file_uid& rhs)
 {
     return(lhs.path == rhs.path && lhs.uid == rhs.uid);
@@ -31,8 +33,8 @@ QVariant hpglListModel::data(const QModelIndex &index, int role) const
     return(QVariant());
 }
 
-bool hpglListModel::dataGroup(const QPersistentModelIndex index,
-                                   QGraphicsItemGroup *& itemGroup)
+bool hpglListModel::dataItem(const QPersistentModelIndex index,
+                             hpglFileItem *& fileItem)
 {
     if (!index.isValid())
     {
@@ -43,43 +45,11 @@ bool hpglListModel::dataGroup(const QPersistentModelIndex index,
         return false;
     }
 
-    itemGroup = hpglData.at(index.row())->hpgl_items_group;
+    fileItem = hpglData.at(index.row())->hpgl_item;
 
     return true;
 }
 
-bool hpglListModel::dataItemsGroup(const QPersistentModelIndex index,
-                                   QGraphicsItemGroup *& itemGroup, QVector<QGraphicsPolygonItem*> *& items)
-{
-    if (!index.isValid())
-    {
-        return false;
-    }
-    if (index.row() >= hpglData.length() || index.row() < 0)
-    {
-        return false;
-    }
-
-    itemGroup = hpglData.at(index.row())->hpgl_items_group;
-    items = &(hpglData.at(index.row())->hpgl_items);
-    return true;
-}
-
-bool hpglListModel::dataItems(const QPersistentModelIndex index, QVector<QGraphicsPolygonItem*> *& items)
-{
-    if (!index.isValid())
-    {
-        return false;
-    }
-    if (index.row() >= hpglData.length() || index.row() < 0)
-    {
-        return false;
-    }
-
-    items = &(hpglData.at(index.row())->hpgl_items);
-    return true;
-}
-
 bool hpglListModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
     QVector<int> changedRoles;
@@ -118,12 +88,54 @@ bool hpglListModel::setFileUid(const QModelIndex &index, const file_uid filename
     return false;
 }
 
-bool hpglListModel::setGroupFlag(const QModelIndex &index, QGraphicsItem::GraphicsItemFlag flag, bool flagValue)
+/**
+ * @brief hpglListModel::snapshot
+ * Everything a plot, time estimate or arrangement reads, copied under a
+ * read lock. Geometry is implicitly shared, so this costs a few pointers
+ * per file and the workers don't touch the lock again.
+ * The scene transforms belong to the scene's thread, so a worker asking
+ * for a snapshot waits while it's taken there.
+ */
+hpglSnapshot hpglListModel::snapshot()
+{
+    if (QThread::currentThread() != thread())
+    {
+        hpglSnapshot retval;
+        QMetaObject::invokeMethod(this, "snapshot", Qt::BlockingQueuedConnection,
+                                  Q_RETURN_ARG(hpglSnapshot, retval));
+        return(retval);
+    }
+
+    hpgl_snapshot * job = new hpgl_snapshot;
+
+    readLock();
+    job->panels = panelData;
+    job->files.reserve(hpglData.length());
+    for (int i = 0; i < hpglData.length(); ++i)
+    {
+        const hpgl_file * file = hpglData.at(i);
+        hpgl_snapshot_file copy;
+        copy.row = i;
+        copy.index = QPersistentModelIndex(index(i));
+        copy.name = file->name;
+        copy.geometry = file->geometry;
+        copy.cutout_box = file->cutout_box;
+        copy.transform = file->hpgl_item->sceneTransform();
+        copy.rect = file->hpgl_item->sceneBoundingRect();
+        copy.panel = panelAtRect(copy.rect);
+        copy.placed = file->placed;
+        job->files.push_back(copy);
+    }
+    mutexUnlock();
+    return(hpglSnapshot(job));
+}
+
+bool hpglListModel::setItemFlag(const QModelIndex &index, QGraphicsItem::GraphicsItemFlag flag, bool flagValue)
 {
     if (index.row() >= 0 && index.row() < hpglData.length())
     {
         mutexLock();
-        hpglData[index.row()]->hpgl_items_group->setFlag(flag, flagValue);
+        hpglData[index.row()]->hpgl_item->setFlag(flag, flagValue);
         mutexUnlock();
         return true;
     }
@@ -148,56 +160,78 @@ int hpglListModel::rowCount(const QModelIndex &parent) const
     return hpglData.length();
 }
 
+/**
+ * @brief hpglListModel::duplicateSelectedRows
+ * Copies share the original's geometry, artwork and plot time, and only get
+ * points of their own if their strokes change. Runs on the scene's thread.
+ * A copy keeps the original's rotation and scale but starts at the origin,
+ * like a newly loaded file. While the original or an earlier copy sits at
+ * that spot it steps one width along the roll; dedup would drop the cuts of
+ * a copy lying right on top of another.
+ */
 void hpglListModel::duplicateSelectedRows()
 {
-    QSettings settings;
-    QModelIndex _index;
     QVector<QPersistentModelIndex> indexes;
 
+    readLock();
     for (int i = 0; i < hpglData.length(); ++i)
     {
-        _index = index(i);
-        mutexLock();
-
-        if (hpglData.at(i)->hpgl_items_group->isSelected())
+        if (hpglData.at(i)->hpgl_item->isSelected())
         {
-            qDebug() << "Index is selected: " << _index;
-            indexes.push_back(_index);
+            indexes.push_back(index(i));
         }
-
-        mutexUnlock();
     }
+    mutexUnlock();
 
     for (int i = 0; i < indexes.length(); ++i)
     {
         QPersistentModelIndex _index = indexes.at(i);
-        QString oldName;
-
-        oldName = data(_index, Qt::DisplayRole).toString();
-
-        mutexLock();
+        if (!_index.isValid())
+        {
+            continue;
+        }
 
-        int newRow = hpglData.length();
+        // Emits the model's insert signals, so not under the lock
+        int newRow = rowCount();
         insertRow(newRow);
         QPersistentModelIndex newIndex = index(newRow);
 
-        mutexUnlock();
-
-        setData(newIndex, oldName, Qt::DisplayRole);
-
-        int loopOffset = 0;
-        if (settings.value("device/cutoutboxes", SETDEF_DEVICE_CUTOUTBOXES).toBool())
-        {
-            loopOffset = 1;
-        }
-        for (int i2 = 0; i2 < (hpglData[_index.row()]->hpgl_items.length() - loopOffset); ++i2)
+        mutexLock();
+        const hpgl_file * source = hpglData.at(_index.row());
+        hpgl_file * copy = hpglData[newRow];
+        copy->name.filename = source->name.filename;
+        copy->name.path = source->name.path;
+        copy->geometry = source->geometry;
+        copy->eta_dirty = source->eta_dirty;
+        copy->eta_time = source->eta_time;
+        copy->eta_first = source->eta_first;
+        copy->eta_last = source->eta_last;
+        copy->rotation_dirty = source->rotation_dirty;
+        copy->rotation_transform = source->rotation_transform;
+        copy->rotation_angle = source->rotation_angle;
+        copy->hpgl_item->shareArtwork(*source->hpgl_item);
+
+        // Rotation and scale follow the original, position is its own
+        hpglFileItem * from = source->hpgl_item;
+        hpglFileItem * to = copy->hpgl_item;
+        to->setTransform(from->transform());
+        to->setTransformOriginPoint(from->transformOriginPoint());
+        to->setRotation(from->rotation());
+        to->setScale(from->scale());
+        QPointF step(qMax(from->sceneBoundingRect().width(), 1.0), 0);
+        for (int i2 = 0; i2 < hpglData.length(); ++i2)
         {
-            const QPolygonF polygon = hpglData[_index.row()]->hpgl_items.at(i2)->polygon();
-//            addPolygon(newIndex, polygon);
-            emit newPolygon(newIndex, polygon);
-//            hpglData[newIndex.row()]->hpgl_items.at(i2)->setPos(hpglData[_index.row()]->hpgl_items.at(i2)->pos());
+            const hpgl_file * other = hpglData.at(i2);
+            if (other != copy && other->hpgl_item->pos() == to->pos() && other->geometry == copy->geometry)
+            {
+                // Taken by the original or an earlier copy, try past it
+                to->setPos(to->pos() + step);
+                i2 = -1;
+            }
         }
+        mutexUnlock();
 
+        emit dataChanged(newIndex, newIndex, QVector<int>() << Qt::DisplayRole);
         emit newFileToScene(newIndex);
     }
 }
@@ -219,13 +253,14 @@ bool hpglListModel::insertRows(int row, int count, const QModelIndex &parent)
         return false;
     }
     beginInsertRows(parent, row, (row + count - 1));
+    mutexLock();
     for (int i = row; i < (row+count); ++i)
     {
         hpgl_file * newFile;
         QModelIndex index = createIndex(i, 0);
         newFile = new hpgl_file;
-        newFile->hpgl_items_group = new QGraphicsItemGroup;
-        newFile->hpgl_items_group->setData(QMODELINDEX_KEY, QPersistentModelIndex(index));
+        newFile->hpgl_item = new hpglFileItem;
+        newFile->hpgl_item->setData(QMODELINDEX_KEY, QPersistentModelIndex(index));
         newFile->name.filename = "NA";
         newFile->name.path = "NA";
         if (hpglData.length() == 0)
@@ -236,9 +271,14 @@ bool hpglListModel::insertRows(int row, int count, const QModelIndex &parent)
         {
             newFile->name.uid = hpglData.last()->name.uid + 1;
         }
-        newFile->hpgl_items.clear();
+        newFile->placed = false;
+        newFile->eta_dirty = true;
+        newFile->eta_time = 0;
+        newFile->rotation_dirty = true;
+        newFile->rotation_angle = 0;
         hpglData.insert(i, newFile);
     }
+    mutexUnlock();
     endInsertRows();
     return true;
 }
@@ -254,8 +294,7 @@ bool hpglListModel::removeRows(int row, int count, const QModelIndex &parent)
     mutexLock();
     for (int i = (row+count-1); i >= row; --i)
     {
-//        delete hpglData[i]->hpgl_items_group;
-        hpglData[i]->hpgl_items.clear();
+        // The scene owns the file's item
         delete hpglData[i];
         hpglData.remove(i);
     }
@@ -264,7 +303,32 @@ bool hpglListModel::removeRows(int row, int count, const QModelIndex &parent)
     return true;
 }
 
-void hpglListModel::addPolygon(QPersistentModelIndex index, QGraphicsPolygonItem * poly)
+/**
+ * @brief hpglListModel::addPolygon
+ * Adds a stroke, in file coordinates, to the file's item.
+ */
+void hpglListModel::addPolygon(QPersistentModelIndex index, const QPolygonF & poly)
+{
+    if (!index.isValid())
+    {
+        qDebug() << "Error invalid index.";
+        return;
+    }
+
+    mutexLock();
+    hpgl_file * file = hpglData[index.row()];
+    file->geometry.push_back(poly);
+    file->hpgl_item->addStroke(poly);
+    file->eta_dirty = true;
+    file->rotation_dirty = true;
+    mutexUnlock();
+}
+
+/**
+ * @brief hpglListModel::addCutoutBox
+ * @param box - scene coordinates, kept in file coordinates so it follows the file
+ */
+void hpglListModel::addCutoutBox(QPersistentModelIndex index, const QPolygonF & box)
 {
     if (!index.isValid())
     {
@@ -273,8 +337,10 @@ void hpglListModel::addPolygon(QPersistentModelIndex index, QGraphicsPolygonItem
     }
 
     mutexLock();
-    hpglData[index.row()]->hpgl_items.push_back(poly);
-    hpglData[index.row()]->hpgl_items_group->addToGroup(static_cast<QGraphicsItem*>(poly));
+    hpgl_file * file = hpglData[index.row()];
+    file->cutout_box = file->hpgl_item->mapFromScene(box);
+    file->hpgl_item->setCutoutBox(file->cutout_box);
+    file->eta_dirty = true;
     mutexUnlock();
 }
 
@@ -287,14 +353,14 @@ void hpglListModel::constrainItems(QPointF bottomLeft, QPointF topLeft, QGraphic
     {
         QPointF pos;
         QRectF rect;
-        QGraphicsItemGroup * itemGroup;
+        hpglFileItem * fileItem;
         modCount = 0;
 
         mutexLock();
 
-        itemGroup = hpglData.at(i)->hpgl_items_group;
-        pos = itemGroup->pos();
-        rect = itemGroup->sceneBoundingRect();
+        fileItem = hpglData.at(i)->hpgl_item;
+        pos = fileItem->pos();
+        rect = fileItem->sceneBoundingRect();
 
         if (rect.x() < bottomLeft.x())
         {
@@ -316,7 +382,7 @@ void hpglListModel::constrainItems(QPointF bottomLeft, QPointF topLeft, QGraphic
 
         if (modCount)
         {
-            itemGroup->setPos(pos);
+            fileItem->setPos(pos);
         }
 
         if ((rect.x() + rect.width()) > length)
@@ -355,25 +421,308 @@ void hpglListModel::constrainItems(QPointF bottomLeft, QPointF topLeft, QGraphic
     emit vinylLength(length);
 }
 
-void hpglListModel::sort()
+/**
+ * @brief hpglListModel::sort
+ * Orders files largest first. Views and persistent indexes follow the
+ * files, so this has to run on the model's own thread.
+ * @param key - hpglSortKey_t
+ */
+void hpglListModel::sort(int key)
 {
-    bool swapped;
-    do
+    sortByKeys(sortKeys(key));
+}
+
+/**
+ * @brief hpglListModel::sortKeys
+ * One key per file, from its bounding box as it lies on the vinyl.
+ */
+QVector<double> hpglListModel::sortKeys(int key)
+{
+    QVector<double> keys;
+
+    readLock();
+    keys.reserve(hpglData.length());
+    for (int i = 0; i < hpglData.length(); ++i)
     {
-        swapped = false;
-        for (int i = 1; i < hpglData.length(); ++i)
+        QRectF rect = hpglData.at(i)->hpgl_item->sceneBoundingRect();
+        switch (key)
         {
-            int max1, max2;
-            max1 = qMax(hpglData.at(i-1)->hpgl_items_group->boundingRect().width(), hpglData.at(i-1)->hpgl_items_group->boundingRect().height());
-            max2 = qMax(hpglData.at(i)->hpgl_items_group->boundingRect().width(), hpglData.at(i)->hpgl_items_group->boundingRect().height());
-            qDebug() << max1 << max2;
-            if (max1 < max2)
-            {
-                hpglData.move(i, i-1);
-                swapped = true;
-            }
+        case SORT_AREA:
+            keys.push_back(rect.width() * rect.height());
+            break;
+        case SORT_PERIMETER:
+            keys.push_back(rect.width() + rect.height());
+            break;
+        default:
+            keys.push_back(qMax(rect.width(), rect.height()));
+            break;
         }
-    } while (swapped);
+    }
+    mutexUnlock();
+    return(keys);
+}
+
+/**
+ * @brief hpglListModel::sortByKeys
+ * Stable sort, largest key first, so files with equal keys keep their order.
+ * @param keys - one per row
+ */
+void hpglListModel::sortByKeys(const QVector<double> & keys)
+{
+    QVector<QPair<double, int> > keyed;
+    QVector<int> newRow(keys.length());
+
+    if (keys.length() != hpglData.length())
+    {
+        qDebug() << "Error: wrong number of sort keys in hpglListModel::sortByKeys().";
+        return;
+    }
+    for (int i = 0; i < keys.length(); ++i)
+    {
+        keyed.push_back(qMakePair(keys.at(i), i));
+    }
+    std::stable_sort(keyed.begin(), keyed.end(),
+                     [](const QPair<double, int> & a, const QPair<double, int> & b) { return a.first > b.first; });
+
+    emit layoutAboutToBeChanged();
+
+    mutexLock();
+    QVector<hpgl_file *> sorted;
+    sorted.reserve(hpglData.length());
+    for (int i = 0; i < keyed.length(); ++i)
+    {
+        sorted.push_back(hpglData.at(keyed.at(i).second));
+        newRow[keyed.at(i).second] = i;
+    }
+    hpglData = sorted;
+    mutexUnlock();
+
+    QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    for (int i = 0; i < from.length(); ++i)
+    {
+        to.push_back(index(newRow.at(from.at(i).row()), from.at(i).column()));
+    }
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged();
+}
+
+bool hpglListModel::isPlaced(const QPersistentModelIndex index)
+{
+    bool placed;
+
+    if (!index.isValid() || index.row() >= hpglData.length() || index.row() < 0)
+    {
+        return false;
+    }
+    readLock();
+    placed = hpglData.at(index.row())->placed;
+    mutexUnlock();
+    return(placed);
+}
+
+void hpglListModel::setPlaced(const QPersistentModelIndex index, bool placed)
+{
+    if (!index.isValid() || index.row() >= hpglData.length() || index.row() < 0)
+    {
+        return;
+    }
+    mutexLock();
+    hpglData[index.row()]->placed = placed;
+    mutexUnlock();
+}
+
+/**
+ * @brief hpglListModel::placeSelectedItems
+ * Files the operator has moved by hand stay where they are on incremental packing.
+ */
+void hpglListModel::placeSelectedItems()
+{
+    mutexLock();
+    for (int i = 0; i < hpglData.length(); ++i)
+    {
+        if (hpglData.at(i)->hpgl_item->isSelected())
+        {
+            hpglData[i]->placed = true;
+        }
+    }
+    mutexUnlock();
+}
+
+QVector<hpgl_panel> hpglListModel::panels()
+{
+    QVector<hpgl_panel> retval;
+    readLock();
+    retval = panelData;
+    mutexUnlock();
+    return(retval);
+}
+
+void hpglListModel::setPanels(const QVector<hpgl_panel> & _panels)
+{
+    mutexLock();
+    panelData = _panels;
+    mutexUnlock();
+    emit panelsChanged();
+}
+
+/**
+ * @brief hpglListModel::panelAt
+ * @return - the remnant panel holding the centre of a file, or -1 for the roll
+ */
+int hpglListModel::panelAt(const QPersistentModelIndex index)
+{
+    int retval = -1;
+
+    if (!index.isValid() || index.row() >= hpglData.length() || index.row() < 0)
+    {
+        return(retval);
+    }
+
+    readLock();
+    retval = panelAtRect(hpglData.at(index.row())->hpgl_item->sceneBoundingRect());
+    mutexUnlock();
+    return(retval);
+}
+
+// Call with the model locked
+int hpglListModel::panelAtRect(const QRectF & rect)
+{
+    for (int i = 0; i < panelData.length(); ++i)
+    {
+        if (!panelData.at(i).roll && panelData.at(i).rect.contains(rect.center()))
+        {
+            return(i);
+        }
+    }
+    return(-1);
+}
+
+/**
+ * @brief hpglListModel::etaCache
+ * @param first, last - item coordinates
+ * @return - false if the file has changed since setEtaCache()
+ */
+bool hpglListModel::etaCache(const QPersistentModelIndex index, double & time,
+                             QPointF & first, QPointF & last)
+{
+    if (!index.isValid() || index.row() >= hpglData.length() || index.row() < 0)
+    {
+        return false;
+    }
+
+    readLock();
+    const hpgl_file * file = hpglData.at(index.row());
+    if (file->eta_dirty)
+    {
+        mutexUnlock();
+        return false;
+    }
+    time = file->eta_time;
+    first = file->eta_first;
+    last = file->eta_last;
+    mutexUnlock();
+    return true;
+}
+
+/**
+ * @brief hpglListModel::etaCaches
+ * Every file's cached plot time in one pass, in row order. Reads the
+ * scene transforms, so only call it on the scene's thread.
+ * @return - false if any file has changed since setEtaCache()
+ */
+bool hpglListModel::etaCaches(QVector<hpgl_eta_cache> & caches)
+{
+    caches.clear();
+
+    readLock();
+    caches.reserve(hpglData.length());
+    for (int i = 0; i < hpglData.length(); ++i)
+    {
+        const hpgl_file * file = hpglData.at(i);
+        if (file->eta_dirty)
+        {
+            mutexUnlock();
+            return false;
+        }
+        QTransform transform = file->hpgl_item->sceneTransform();
+        hpgl_eta_cache cache;
+        cache.time = file->eta_time;
+        cache.first = transform.map(file->eta_first);
+        cache.last = transform.map(file->eta_last);
+        caches.push_back(cache);
+    }
+    mutexUnlock();
+    return true;
+}
+
+void hpglListModel::setEtaCache(const QPersistentModelIndex index, double time, QPointF first, QPointF last)
+{
+    if (!index.isValid() || index.row() >= hpglData.length() || index.row() < 0)
+    {
+        return;
+    }
+
+    mutexLock();
+    hpgl_file * file = hpglData[index.row()];
+    file->eta_time = time;
+    file->eta_first = first;
+    file->eta_last = last;
+    file->eta_dirty = false;
+    mutexUnlock();
+}
+
+/**
+ * @brief hpglListModel::invalidateEta
+ * For when the motion settings change.
+ */
+void hpglListModel::invalidateEta()
+{
+    mutexLock();
+    for (int i = 0; i < hpglData.length(); ++i)
+    {
+        hpglData[i]->eta_dirty = true;
+    }
+    mutexUnlock();
+}
+
+/**
+ * @brief hpglListModel::rotationCache
+ * @param transform - the linear part of the file's scene transform now
+ * @return - false if the file or its transform has changed since setRotationCache()
+ */
+bool hpglListModel::rotationCache(const QPersistentModelIndex index, const QTransform & transform, double & angle)
+{
+    if (!index.isValid() || index.row() >= hpglData.length() || index.row() < 0)
+    {
+        return false;
+    }
+
+    readLock();
+    const hpgl_file * file = hpglData.at(index.row());
+    if (file->rotation_dirty || file->rotation_transform != transform)
+    {
+        mutexUnlock();
+        return false;
+    }
+    angle = file->rotation_angle;
+    mutexUnlock();
+    return true;
+}
+
+void hpglListModel::setRotationCache(const QPersistentModelIndex index, const QTransform & transform, double angle)
+{
+    if (!index.isValid() || index.row() >= hpglData.length() || index.row() < 0)
+    {
+        return;
+    }
+
+    mutexLock();
+    hpglData[index.row()]->rotation_dirty = false;
+    hpglData[index.row()]->rotation_transform = transform;
+    hpglData[index.row()]->rotation_angle = angle;
+    mutexUnlock();
 }
 
 void hpglListModel::rotateSelectedItems(qreal rotation)
@@ -386,16 +735,16 @@ void hpglListModel::rotateSelectedItems(qreal rotation)
     {
         _index = index(i);
 
-        QGraphicsItemGroup * itemGroup = hpglData.at(i)->hpgl_items_group;
+        hpglFileItem * fileItem = hpglData.at(i)->hpgl_item;
 
-        if (itemGroup->isSelected())
+        if (fileItem->isSelected())
         {
-            xOffset = itemGroup->boundingRect().x();
-            yOffset = itemGroup->boundingRect().y();
-            translateWidth = itemGroup->boundingRect().width();
-            translateheight = itemGroup->boundingRect().height();
-            itemGroup->setTransformOriginPoint((translateWidth/2.0)+xOffset, (translateheight/2.0)+yOffset);
-            itemGroup->setRotation(itemGroup->rotation() + rotation);
+            xOffset = fileItem->boundingRect().x();
+            yOffset = fileItem->boundingRect().y();
+            translateWidth = fileItem->boundingRect().width();
+            translateheight = fileItem->boundingRect().height();
+            fileItem->setTransformOriginPoint((translateWidth/2.0)+xOffset, (translateheight/2.0)+yOffset);
+            fileItem->setRotation(fileItem->rotation() + rotation);
         }
     }
     mutexUnlock();
@@ -412,16 +761,17 @@ void hpglListModel::scaleSelectedItems(qreal x, qreal y)
     {
         _index = index(i);
 
-        QGraphicsItemGroup * itemGroup = hpglData.at(i)->hpgl_items_group;
+        hpglFileItem * fileItem = hpglData.at(i)->hpgl_item;
 
-        if (itemGroup->isSelected())
+        if (fileItem->isSelected())
         {
-            translateWidth = itemGroup->boundingRect().width();
-            translateheight = itemGroup->boundingRect().height();
+            translateWidth = fileItem->boundingRect().width();
+            translateheight = fileItem->boundingRect().height();
             transform.translate(translateWidth/2.0, translateheight/2.0);
             transform.scale(x, y);
             transform.translate(-translateWidth/2.0, -translateheight/2.0);
-            itemGroup->setTransform(itemGroup->transform() * transform);
+            fileItem->setTransform(fileItem->transform() * transform);
+            hpglData[i]->eta_dirty = true;
         }
     }
     mutexUnlock();
@@ -444,12 +794,12 @@ void hpglListModel::createCutoutBox(QPersistentModelIndex _index)
         padding = padding * 2.54;
     }
     padding = padding * 1016.0;
-    QRectF cutoutRect = hpglData.at(_index.row())->hpgl_items_group->sceneBoundingRect();
+    QRectF cutoutRect = hpglData.at(_index.row())->hpgl_item->sceneBoundingRect();
     cutoutRect = cutoutRect.marginsAdded(QMarginsF(padding, padding, padding, padding));
 
     mutexUnlock();
 
-    emit newPolygon(_index, static_cast<QPolygonF>(cutoutRect));
+    addCutoutBox(_index, static_cast<QPolygonF>(cutoutRect));
 }
 
 void hpglListModel::createCutoutBoxes()
@@ -462,19 +812,21 @@ void hpglListModel::createCutoutBoxes()
 
 void hpglListModel::removeCutoutBox(QPersistentModelIndex _index)
 {
-    QVector<QGraphicsPolygonItem *> * items;
-
     if (_index.row() < 0 || _index.row() >= hpglData.length() || !_index.isValid())
     {
         return;
     }
 
-    items = &(hpglData[_index.row()]->hpgl_items);
-
-    hpglData[_index.row()]->hpgl_items_group->removeFromGroup(items->last());
-    hpglData[_index.row()]->hpgl_items_group->scene()->removeItem(items->last());
-    delete items->last();
-    items->removeLast();
+    mutexLock();
+    if (hpglData.at(_index.row())->cutout_box.isEmpty())
+    {
+        mutexUnlock();
+        return;
+    }
+    hpglData[_index.row()]->hpgl_item->setCutoutBox(QPolygonF());
+    hpglData[_index.row()]->cutout_box.clear();
+    hpglData[_index.row()]->eta_dirty = true;
+    mutexUnlock();
 }
 
 void hpglListModel::removeCutoutBoxes()
@@ -487,22 +839,32 @@ void hpglListModel::removeCutoutBoxes()
 
 void hpglListModel::mutexLock()
 {
-    mutex.lock();
+    lock.lockForWrite();
+}
+
+/**
+ * @brief hpglListModel::readLock
+ * For looking without changing anything, any number of readers at once.
+ * Release with mutexUnlock().
+ */
+void hpglListModel::readLock()
+{
+    lock.lockForRead();
 }
 
 void hpglListModel::mutexUnlock()
 {
-    mutex.unlock();
+    lock.unlock();
 }
 
 bool hpglListModel::mutexIsLocked()
 {
-    if (!mutex.tryLock())
+    if (!lock.tryLockForWrite())
     {
-        // Mutex already locked
+        // Already locked
         return true;
     }
-    mutex.unlock();
+    lock.unlock();
     return false;
 }
 
@@ -8,18 +8,31 @@
 #include <QtCore>
 #include <QAbstractListModel>
 #include <QAbstractItemModel>
-#include <QGraphicsItemGroup>
 #include <QGraphicsRectItem>
-#include <QMutex>
-#include <QMutexLocker>
+#include <QPolygonF>
+#include <QReadWriteLock>
+#include <QSharedPointer>
 #include <QGraphicsScene>
 #include <math.h>
 #include <QGraphicsRectItem>
 
 #include "settings.h"
+#include "hpglfileitem.h"
 
 #define QMODELINDEX_KEY (1)
 
+// Keys hpglListModel::sort() can order files by, largest first
+enum hpglSortKey_t {
+    SORT_LONGEST_SIDE = 0,
+    SORT_AREA,
+    SORT_PERIMETER,
+    SORT_SIZE_OF_ENUM
+};
+static const char* hpglSortKey_names[] = {"Longest side", "Area", "Perimeter"};
+
+static_assert(sizeof(hpglSortKey_names)/sizeof(char*) == hpglSortKey_t::SORT_SIZE_OF_ENUM
+    , "Model sort key names dont match");
+
 // hpgl structs
 struct file_uid {
     QString filename;
@@ -29,11 +42,59 @@ struct file_uid {
 
 struct hpgl_file {
     file_uid name;
-    QVector<QGraphicsPolygonItem *> hpgl_items;
-    QGraphicsItemGroup * hpgl_items_group;
+    hpglFileItem * hpgl_item;
+    // Strokes and cutout box in file coordinates, implicitly shared with snapshots
+    QVector<QPolygonF> geometry;
+    QPolygonF cutout_box;   // empty without one
+    bool placed;        // arranged or positioned by hand, kept by incremental packing
+    // Plot time cache, in item coordinates so moves and rotations keep it
+    bool eta_dirty;
+    double eta_time;    // strokes and the travel between them
+    QPointF eta_first;  // pen down point of the first stroke
+    QPointF eta_last;   // pen up point of the last stroke
+    // Tightest rotation cache, for the linear part of the scene transform
+    bool rotation_dirty;
+    QTransform rotation_transform;
+    double rotation_angle;
 };
 bool operator==(const file_uid& lhs, const file_uid& rhs);
 
+// A separate piece of material, plotted on its own from its top left corner
+struct hpgl_panel {
+    QString name;
+    QRectF rect;        // scene area the piece is drawn in
+    QPolygonF outline;  // scene coordinates
+    bool roll;          // a length of the roll, files crossing its ends are cut there
+};
+
+// A file as it was when a job snapshot was taken
+struct hpgl_snapshot_file {
+    int row;
+    QPersistentModelIndex index;    // the live file, wherever its row has gone since
+    file_uid name;
+    QVector<QPolygonF> geometry;    // strokes, file coordinates
+    QPolygonF cutout_box;           // file coordinates, empty without one
+    QTransform transform;           // file to scene
+    QRectF rect;                    // scene bounding rect
+    int panel;                      // as panelAt()
+    bool placed;
+};
+
+// A file's cached plot time, endpoints in scene coordinates
+struct hpgl_eta_cache {
+    double time;
+    QPointF first;
+    QPointF last;
+};
+
+// Everything the workers read, immutable once taken
+struct hpgl_snapshot {
+    QVector<hpgl_snapshot_file> files;
+    QVector<hpgl_panel> panels;
+};
+typedef QSharedPointer<const hpgl_snapshot> hpglSnapshot;
+Q_DECLARE_METATYPE(hpglSnapshot)
+
 namespace std {
 class hpglListModel;
 }
@@ -47,32 +108,50 @@ public:
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role) const;
-    bool dataGroup(const QPersistentModelIndex index,
-                    QGraphicsItemGroup *&itemGroup);
-    bool dataItemsGroup(const QPersistentModelIndex index,
-                        QGraphicsItemGroup *&itemGroup, QVector<QGraphicsPolygonItem *> *&items);
-    bool dataItems(const QPersistentModelIndex index,
-                   QVector<QGraphicsPolygonItem *> *&items);
+    bool dataItem(const QPersistentModelIndex index,
+                  hpglFileItem *&fileItem);
     bool setData(const QModelIndex &index, const QVariant &value, int role);
-    bool setGroupFlag(const QModelIndex &index, QGraphicsItem::GraphicsItemFlag flag, bool flagValue);
+    bool setItemFlag(const QModelIndex &index, QGraphicsItem::GraphicsItemFlag flag, bool flagValue);
     QModelIndex index(int row, int column = 0, const QModelIndex &parent = QModelIndex()) const;
     bool insertRow(int row, const QModelIndex &parent = QModelIndex());
     bool removeRow(int row, const QModelIndex &parent = QModelIndex());
     bool insertRows(int row, int count, const QModelIndex &parent = QModelIndex());
     bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex());
-    void addPolygon(QPersistentModelIndex index, QGraphicsPolygonItem * poly);
+    void addPolygon(QPersistentModelIndex index, const QPolygonF & poly);
+    void addCutoutBox(QPersistentModelIndex index, const QPolygonF & box);
     void constrainItems(QPointF bottomLeft, QPointF topLeft, QGraphicsRectItem *vinyl);
+    Q_INVOKABLE hpglSnapshot snapshot();
     bool setFileUid(const QModelIndex &index, const file_uid filename);
-    void sort();
+    QVector<double> sortKeys(int key);
+    void sortByKeys(const QVector<double> & keys);
+    // Layout
+    bool isPlaced(const QPersistentModelIndex index);
+    void setPlaced(const QPersistentModelIndex index, bool placed);
+    void placeSelectedItems();
+    // Panels, everything outside them is on the roll
+    QVector<hpgl_panel> panels();
+    void setPanels(const QVector<hpgl_panel> & _panels);
+    int panelAt(const QPersistentModelIndex index);
+    // Plot time cache
+    bool etaCache(const QPersistentModelIndex index, double & time,
+                  QPointF & first, QPointF & last);
+    bool etaCaches(QVector<hpgl_eta_cache> & caches);
+    void setEtaCache(const QPersistentModelIndex index, double time, QPointF first, QPointF last);
+    void invalidateEta();
+    // Rotation cache
+    bool rotationCache(const QPersistentModelIndex index, const QTransform & transform, double & angle);
+    void setRotationCache(const QPersistentModelIndex index, const QTransform & transform, double angle);
     // Item transformations
     void rotateSelectedItems(qreal rotation);
     void scaleSelectedItems(qreal x, qreal y);
-    // Mutex
+    // Lock, shared for readers
     void mutexLock();
+    void readLock();
     void mutexUnlock();
     bool mutexIsLocked();
 
 public slots:
+    void sort(int key = SORT_LONGEST_SIDE);
     void createCutoutBox(QPersistentModelIndex _index);
     void createCutoutBoxes();
     void removeCutoutBoxes();
@@ -83,11 +162,15 @@ signals:
     void newPolygon(QPersistentModelIndex,QPolygonF);
     void newFileToScene(QPersistentModelIndex);
     void vinylLength(int);
+    void panelsChanged();
 
 private:
     QVector<hpgl_file *> hpglData;
+    QVector<hpgl_panel> panelData;
     QObject * modelParent;
-    QMutex mutex;
+    QReadWriteLock lock;
+
+    int panelAtRect(const QRectF & rect);
 };
 
 #endif // HPGLLISTMODEL_H
@@ -16,12 +16,23 @@ SOURCES += main.cpp\
 	settings.cpp \
 	hpglgraphicsview.cpp \
 	hpgllistmodel.cpp \
+	hpglfileitem.cpp \
 	RectangleBinPack/ShelfBinPack.cpp \
 	RectangleBinPack/GuillotineBinPack.cpp \
     RectangleBinPack/MaxRectsBinPack.cpp \
+    RectangleBinPack/SkylineBinPack.cpp \
     RectangleBinPack/Rect.cpp \
     ext/plot.cpp \
+    ext/encoder.cpp \
+    ext/geometry.cpp \
     ext/binpack.cpp \
+    ext/nest.cpp \
+    ext/strippack.cpp \
+    ext/freespace.cpp \
+    ext/remnants.cpp \
+    ext/rollsplit.cpp \
+    ext/dedup.cpp \
+    ext/optimize.cpp \
     ext/eta.cpp \
     ext/loadfile.cpp \
     dialog/dialogabout.cpp \
@@ -32,12 +43,23 @@ HEADERS  += mainwindow.h \
 	settings.h \
 	hpglgraphicsview.h \
 	hpgllistmodel.h \
+	hpglfileitem.h \
 	RectangleBinPack/Rect.h \
 	RectangleBinPack/ShelfBinPack.h \
 	RectangleBinPack/GuillotineBinPack.h \
     RectangleBinPack/MaxRectsBinPack.h \
+    RectangleBinPack/SkylineBinPack.h \
     ext/plot.h \
+    ext/encoder.h \
+    ext/geometry.h \
     ext/binpack.h \
+    ext/nest.h \
+    ext/strippack.h \
+    ext/freespace.h \
+    ext/remnants.h \
+    ext/rollsplit.h \
+    ext/dedup.h \
+    ext/optimize.h \
     ext/eta.h \
     ext/loadfile.h \
     dialog/dialogabout.h \
@@ -15,6 +15,7 @@ int main(int argc, char *argv[])
     // Required setup to pass custom item in signal/slot.
     qRegisterMetaType<file_uid>("file_uid");
     qRegisterMetaType<hpglListModel*>("hpglListModel*");
+    qRegisterMetaType<hpglSnapshot>("hpglSnapshot");
 
     return a.exec();
 }
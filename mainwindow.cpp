@@ -43,6 +43,8 @@ MainWindow::MainWindow(QWidget *parent) :
 
     ui->setupUi(this);
     hpglModel = new hpglListModel(this);
+    plotPlanNext = 0;
+    etaMotion = ExtEta::motionProfile();
 
     // Connect UI actions
     connect(ui->actionExit, SIGNAL(triggered(bool)), this, SLOT(close()));
@@ -60,7 +62,17 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionFlip_Horizontal, SIGNAL(triggered(bool)), this, SLOT(handle_flipXbtn()));
     connect(ui->actionFlip_Vertical, SIGNAL(triggered(bool)), this, SLOT(handle_flipYbtn()));
     connect(ui->actionAuto_Arrange, SIGNAL(triggered(bool)), this, SLOT(do_binpack()));
+    connect(ui->actionArrange_New, SIGNAL(triggered(bool)), this, SLOT(do_binpackNew()));
+    connect(ui->actionNest, SIGNAL(triggered(bool)), this, SLOT(do_nest()));
+    connect(ui->actionOptimize_Layout, SIGNAL(triggered(bool)), this, SLOT(do_optimizeLayout()));
+    connect(ui->actionArrange_Remnants, SIGNAL(triggered(bool)), this, SLOT(do_binpackRemnants()));
+    connect(ui->actionAdd_Remnant, SIGNAL(triggered(bool)), this, SLOT(do_addRemnant()));
+    connect(ui->actionRemnant_From_Selection, SIGNAL(triggered(bool)), this, SLOT(do_addRemnantFromSelection()));
+    connect(ui->actionRemove_Remnant, SIGNAL(triggered(bool)), this, SLOT(do_removeRemnant()));
     connect(ui->actionPlot, SIGNAL(triggered(bool)), this, SLOT(do_plot()));
+    connect(ui->actionSplit_Rolls, SIGNAL(triggered(bool)), this, SLOT(do_splitRolls()));
+    connect(ui->actionResume_Plot, SIGNAL(triggered(bool)), this, SLOT(do_resumePlot()));
+    connect(ui->actionCalibrate_Eta, SIGNAL(triggered(bool)), this, SLOT(do_calibrateEta()));
     connect(ui->actionJog, SIGNAL(triggered(bool)), this, SLOT(do_jog()));
     connect(ui->actionZoom_In, SIGNAL(triggered(bool)), ui->graphicsView_view, SLOT(zoomIn()));
     connect(ui->actionZoom_Out, SIGNAL(triggered(bool)), ui->graphicsView_view, SLOT(zoomOut()));
@@ -78,6 +90,7 @@ MainWindow::MainWindow(QWidget *parent) :
     // Connect other UI elements
     connect(ui->splitter, SIGNAL(splitterMoved(int,int)), this, SLOT(handle_splitterMoved()));
     connect(&plotScene, SIGNAL(changed(QList<QRectF>)), this, SLOT(sceneConstrainItems()));
+    connect(&plotScene, SIGNAL(changed(QList<QRectF>)), this, SLOT(handle_sceneChangedEta()));
 //    connect(&plotScene, SIGNAL(sceneRectChanged(QRectF)), this, SLOT(sceneSetSceneRect(QRectF)));
     connect(ui->graphicsView_view, SIGNAL(zoomUpdate(QString)), this, SLOT(handle_zoomChanged(QString)));
     connect(ui->graphicsView_view, SIGNAL(statusUpdate(QString,QColor)), this, SLOT(handle_newConsoleText(QString,QColor)));
@@ -88,8 +101,10 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(hpglModel, SIGNAL(newPolygon(QPersistentModelIndex,QPolygonF)), this, SLOT(addPolygon(QPersistentModelIndex,QPolygonF)));
     connect(hpglModel, SIGNAL(newFileToScene(QPersistentModelIndex)), this, SLOT(newFileToScene(QPersistentModelIndex)));
     connect(hpglModel, SIGNAL(vinylLength(int)), this, SLOT(handle_vinylLengthChanged(int)));
+    connect(hpglModel, SIGNAL(panelsChanged()), this, SLOT(handle_panelsChanged()));
 
     connect(ui->graphicsView_view, SIGNAL(zoomUpdate(QString)), this, SLOT(setGrid()));
+    connect(ui->graphicsView_view, SIGNAL(mouseReleased()), this, SLOT(handle_sceneMouseReleased()));
 
 //    connect(QGuiApplication::primaryScreen(), SIGNAL(physicalDotsPerInchChanged(qreal)),
 //            this, SLOT(sceneSetup())); // Update view if the pixel DPI changes
@@ -217,6 +232,10 @@ void MainWindow::do_openDialogSettings()
     newwindow->setWindowTitle("localplot settings");
     connect(newwindow, SIGNAL(toggleCutoutBoxes(bool)), ui->actionToggle_CutoutBoxes, SLOT(setChecked(bool)));
     newwindow->exec();
+    // Speeds may have changed
+    etaMotion = ExtEta::motionProfile();
+    hpglModel->invalidateEta();
+    do_procEta();
 //    widthLine->setLine(get_widthLine());
     // TODO: fix vinyl box height resizing
     ui->graphicsView_view->setGrid();
@@ -395,13 +414,94 @@ void MainWindow::do_plot()
 {
     ExtPlot * worker;
 
+    if (ExtPlot::hasCheckpoint())
+    {
+        QMessageBox::StandardButton reply;
+        reply = QMessageBox::question(this, "Plot checkpoint",
+                                      "A cancelled plot can still be resumed. Start a new plot and discard it?",
+                                      QMessageBox::Yes | QMessageBox::No);
+        if (reply != QMessageBox::Yes)
+        {
+            return;
+        }
+        ExtPlot::clearCheckpoint();
+    }
+
+    // Lengths of roll and remnants are loaded and plotted one at a time
+    int panel = -1;
+    QVector<int> plan = plotPlan();
+    if (plan.length() > 1 || (!plan.isEmpty() && plan.first() >= 0))
+    {
+        QVector<hpgl_panel> panels = hpglModel->panels();
+        QStringList names;
+        bool ok;
+        for (int i = 0; i < plan.length(); ++i)
+        {
+            if (plan.at(i) < 0)
+            {
+                names << "Roll";
+            }
+            else if (panels.at(plan.at(i)).roll)
+            {
+                names << panels.at(plan.at(i)).name;
+            }
+            else
+            {
+                names << "Remnant: " + panels.at(plan.at(i)).name;
+            }
+        }
+        QString choice = QInputDialog::getItem(this, "Plot", "Material to plot:", names,
+                                               qBound(0, plotPlanNext, names.length()-1), false, &ok);
+        if (!ok)
+        {
+            return;
+        }
+        int step = names.indexOf(choice);
+        panel = plan.at(step);
+        plotPlanNext = step + 1;
+    }
+
+    worker = new ExtPlot(hpglModel);
+    worker->setPanel(panel);
+    startPlot(worker);
+}
+
+void MainWindow::do_resumePlot()
+{
+    ExtPlot * worker;
+    QSettings settings;
+
+    if (!ExtPlot::hasCheckpoint())
+    {
+        handle_newConsoleText("No plot checkpoint to resume from.", Qt::darkRed);
+        return;
+    }
+
+    QMessageBox::StandardButton reply;
+    reply = QMessageBox::question(this, "Resume plot",
+                                  "Resume the last plot at stroke "
+                                  + settings.value("plot/checkpoint/stroke", SETDEF_PLOT_CHECKPOINT_STROKE).toString()
+                                  + " of " + settings.value("plot/checkpoint/total", 0).toString()
+                                  + "? Make sure the material hasn't moved.",
+                                  QMessageBox::Yes | QMessageBox::No);
+    if (reply != QMessageBox::Yes)
+    {
+        return;
+    }
+
     worker = new ExtPlot(hpglModel);
+    worker->setResumeFromCheckpoint(true);
+    startPlot(worker);
+}
 
+void MainWindow::startPlot(ExtPlot * worker)
+{
     // Create progress window
     DialogProgress * newwindow;
     newwindow = new DialogProgress(this);
     newwindow->setWindowTitle("Plotting Progress");
     newwindow->enableHookCheckbox();
+    newwindow->enablePauseButton();
 
     // Create plotting process in new thread
     QThread * workerThread = new QThread;
@@ -415,8 +515,12 @@ void MainWindow::do_plot()
 
     // Connect progress window
     connect(newwindow, SIGNAL(do_cancel()), worker, SLOT(cancel()));
+    connect(newwindow, SIGNAL(do_pause()), worker, SLOT(pause()));
+    connect(newwindow, SIGNAL(do_resume()), worker, SLOT(resume()));
     connect(worker, SIGNAL(finished()), newwindow, SLOT(close()));
     connect(worker, SIGNAL(progress(int)), newwindow, SLOT(handle_updateProgress(int)));
+    connect(worker, SIGNAL(plotStatus(qint64,qint64,double,double)),
+            newwindow, SLOT(handle_plotStatus(qint64,qint64,double,double)));
 
     // Start
     workerThread->start();
@@ -429,24 +533,24 @@ void MainWindow::do_jog()
 
     QRectF perimeter;
     QModelIndex index;
-    QGraphicsItemGroup * itemGroup;
+    hpglFileItem * fileItem;
     qreal x1, y1, x2, y2;
 
     for (int i = 0; i < hpglModel->rowCount(); ++i)
     {
         index = hpglModel->index(i);
-        itemGroup = NULL;
-        hpglModel->dataGroup(index, itemGroup);
+        fileItem = NULL;
+        hpglModel->dataItem(index, fileItem);
         hpglModel->mutexLock();
 
-        if (itemGroup == NULL)
+        if (fileItem == NULL)
         {
-            qDebug() << "Error: itemgroup is null in scenescalecontainselected().";
+            qDebug() << "Error: file item is null in scenescalecontainselected().";
             hpglModel->mutexUnlock();
             return;
         }
 
-        itemGroup->mapRectToScene(itemGroup->boundingRect()).getCoords(&x1, &y1, &x2, &y2);
+        fileItem->mapRectToScene(fileItem->boundingRect()).getCoords(&x1, &y1, &x2, &y2);
         if (x1 < perimeter.x())
         {
             perimeter.setX(x1);
@@ -591,7 +695,75 @@ void MainWindow::do_procEta()
     workerThread->start();
 }
 
+/**
+ * @brief MainWindow::handle_sceneChangedEta
+ * Files moving around only changes the travel between them, so the
+ * cached file times are enough. Edited files wait for do_procEta().
+ */
+void MainWindow::handle_sceneChangedEta()
+{
+    double eta;
+
+    if (ExtEta::cachedTime(hpglModel, etaMotion, eta))
+    {
+        handle_plottingEta(eta);
+    }
+}
+
+/**
+ * @brief MainWindow::do_calibrateEta
+ * Fits the motion model to the recorded plot sessions for the current port.
+ */
+void MainWindow::do_calibrateEta()
+{
+    QString report;
+    eta_calibration fitted;
+
+    if (!ExtEta::calibrate(report, fitted))
+    {
+        handle_newConsoleText(report, Qt::darkRed);
+        return;
+    }
+    handle_newConsoleText(report, Qt::black);
+
+    QMessageBox::StandardButton reply;
+    reply = QMessageBox::question(this, "Calibrate ETA",
+                                  report + "\n\nUse this profile for " + ExtEta::profileKey() + "?",
+                                  QMessageBox::Yes | QMessageBox::No);
+    if (reply != QMessageBox::Yes)
+    {
+        return;
+    }
+    ExtEta::saveProfile(fitted);
+    etaMotion = ExtEta::motionProfile();
+    hpglModel->invalidateEta();
+    do_procEta();
+}
+
 void MainWindow::do_binpack()
+{
+    startBinpack(false);
+}
+
+/**
+ * @brief MainWindow::do_binpackNew
+ * Arranges only files that haven't been placed yet.
+ */
+void MainWindow::do_binpackNew()
+{
+    startBinpack(true);
+}
+
+/**
+ * @brief MainWindow::do_binpackRemnants
+ * Arranges onto the remnant inventory first and the roll last.
+ */
+void MainWindow::do_binpackRemnants()
+{
+    startBinpack(false, true);
+}
+
+void MainWindow::startBinpack(bool incremental, bool remnants)
 {
     // Create progress window
     DialogProgress * newwindow;
@@ -601,17 +773,21 @@ void MainWindow::do_binpack()
     // Process in new thread
     QThread * workerThread = new QThread;
     ExtBinPack * worker = new ExtBinPack(hpglModel);
+    worker->setIncremental(incremental);
+    worker->setRemnants(remnants);
     worker->moveToThread(workerThread);
     connect(workerThread, SIGNAL(started()), worker, SLOT(process()));
     connect(workerThread, SIGNAL(finished()), worker, SLOT(deleteLater()));
     connect(worker, SIGNAL(finished()), workerThread, SLOT(quit()));
     connect(worker, SIGNAL(finished()), worker, SLOT(deleteLater()));
     connect(worker, SIGNAL(packedRect(QPersistentModelIndex,QRectF)), this, SLOT(handle_packedRect(QPersistentModelIndex,QRectF)));
+    connect(worker, SIGNAL(rotatedItem(QPersistentModelIndex,QTransform)), this, SLOT(handle_rotatedItem(QPersistentModelIndex,QTransform)),
+            Qt::BlockingQueuedConnection);
     connect(worker, SIGNAL(statusUpdate(QString,QColor)), this, SLOT(handle_newConsoleText(QString,QColor)));
-    connect(this, SIGNAL(please_plotter_cancelPlot()), worker, SLOT(cancel()));
+    connect(this, SIGNAL(please_plotter_cancelPlot()), worker, SLOT(cancel()), Qt::DirectConnection);
 
     // Connect progress window
-    connect(newwindow, SIGNAL(do_cancel()), worker, SLOT(cancel()));
+    connect(newwindow, SIGNAL(do_cancel()), worker, SLOT(cancel()), Qt::DirectConnection);
     connect(worker, SIGNAL(finished()), newwindow, SLOT(close()));
     connect(worker, SIGNAL(progress(int)), newwindow, SLOT(handle_updateProgress(int)));
 
@@ -620,40 +796,460 @@ void MainWindow::do_binpack()
     newwindow->exec();
 }
 
-void MainWindow::handle_packedRect(QPersistentModelIndex index, QRectF rect)
+void MainWindow::do_nest()
+{
+    // Create progress window
+    DialogProgress * newwindow;
+    newwindow = new DialogProgress(this);
+    newwindow->setWindowTitle("Nesting Progress");
+
+    // Process in new thread
+    QThread * workerThread = new QThread;
+    ExtNest * worker = new ExtNest(hpglModel);
+    worker->moveToThread(workerThread);
+    connect(workerThread, SIGNAL(started()), worker, SLOT(process()));
+    connect(workerThread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+    connect(worker, SIGNAL(finished()), workerThread, SLOT(quit()));
+    connect(worker, SIGNAL(finished()), worker, SLOT(deleteLater()));
+    connect(worker, SIGNAL(nestedItem(QPersistentModelIndex,QTransform)), this, SLOT(handle_nestedItem(QPersistentModelIndex,QTransform)));
+    connect(worker, SIGNAL(statusUpdate(QString,QColor)), this, SLOT(handle_newConsoleText(QString,QColor)));
+
+    // Connect progress window
+    connect(newwindow, SIGNAL(do_cancel()), worker, SLOT(cancel()), Qt::DirectConnection);
+    connect(worker, SIGNAL(finished()), newwindow, SLOT(close()));
+    connect(worker, SIGNAL(progress(int)), newwindow, SLOT(handle_updateProgress(int)));
+
+    // Start
+    workerThread->start();
+    newwindow->exec();
+}
+
+/**
+ * @brief MainWindow::do_optimizeLayout
+ * Aborting the progress window stops the search and keeps the best layout.
+ */
+void MainWindow::do_optimizeLayout()
+{
+    // Create progress window
+    DialogProgress * newwindow;
+    newwindow = new DialogProgress(this);
+    newwindow->setWindowTitle("Optimizing Layout");
+
+    // Process in new thread
+    QThread * workerThread = new QThread;
+    ExtOptimize * worker = new ExtOptimize(hpglModel);
+    worker->moveToThread(workerThread);
+    connect(workerThread, SIGNAL(started()), worker, SLOT(process()));
+    connect(workerThread, SIGNAL(finished()), worker, SLOT(deleteLater()));
+    connect(worker, SIGNAL(finished()), workerThread, SLOT(quit()));
+    connect(worker, SIGNAL(finished()), worker, SLOT(deleteLater()));
+    connect(worker, SIGNAL(packedRect(QPersistentModelIndex,QRectF)), this, SLOT(handle_packedRect(QPersistentModelIndex,QRectF)));
+    connect(worker, SIGNAL(statusUpdate(QString,QColor)), this, SLOT(handle_newConsoleText(QString,QColor)));
+
+    // Connect progress window
+    connect(newwindow, SIGNAL(do_cancel()), worker, SLOT(cancel()), Qt::DirectConnection);
+    connect(worker, SIGNAL(finished()), newwindow, SLOT(close()));
+    connect(worker, SIGNAL(progress(int)), newwindow, SLOT(handle_updateProgress(int)));
+
+    // Start
+    workerThread->start();
+    newwindow->exec();
+}
+
+/**
+ * @brief MainWindow::do_addRemnant
+ * Adds a rectangular offcut, measured in the device width units.
+ */
+void MainWindow::do_addRemnant()
 {
-    QGraphicsItemGroup * itemGroup;
-    itemGroup = NULL;
     QSettings settings;
+    QString unit = "inches";
+    double scale = 1016.0;
+    bool ok;
+
+    if (settings.value("device/width/type", SETDEF_DEVICE_WDITH_TYPE).toInt() == deviceWidth_t::CM)
+    {
+        unit = "cm";
+        scale = 1016.0 / 2.54;
+    }
+
+    remnant_piece piece;
+    piece.name = QInputDialog::getText(this, "Add Remnant", "Name:", QLineEdit::Normal,
+                                       "Remnant " + QString::number(hpglRemnants::load().length() + 1), &ok);
+    if (!ok)
+    {
+        return;
+    }
+    double width = QInputDialog::getDouble(this, "Add Remnant", "Width across the cutter (" + unit + "):",
+                                           1, 0.1, 1000, 2, &ok);
+    if (!ok)
+    {
+        return;
+    }
+    double length = QInputDialog::getDouble(this, "Add Remnant", "Length (" + unit + "):",
+                                            1, 0.1, 10000, 2, &ok);
+    if (!ok)
+    {
+        return;
+    }
+
+    piece.outline = QPolygonF(QRectF(0, 0, width * scale, length * scale));
+    hpglRemnants::add(piece);
+    handle_newConsoleText("Added remnant " + piece.name + " to the inventory.");
+}
+
+/**
+ * @brief MainWindow::do_addRemnantFromSelection
+ * Adds an irregular offcut from a traced outline: the largest polygon in
+ * the first selected file.
+ */
+void MainWindow::do_addRemnantFromSelection()
+{
+    QModelIndexList list;
+    remnant_piece piece;
+    double bestArea = 0;
+    bool ok;
+
+    list = ui->listView->selectionModel()->selectedIndexes();
+    if (list.isEmpty())
+    {
+        handle_newConsoleText("Select the file with the remnant's outline first.", Qt::darkRed);
+        return;
+    }
+
+    hpglSnapshot job = hpglModel->snapshot();
+    if (list.first().row() >= job->files.length())
+    {
+        return;
+    }
+    const hpgl_snapshot_file & file = job->files.at(list.first().row());
+    for (int i = 0; i < file.geometry.length(); ++i)
+    {
+        double area = hpglRemnants::area(file.geometry.at(i));
+        if (area > bestArea)
+        {
+            bestArea = area;
+            piece.outline = file.transform.map(file.geometry.at(i));
+        }
+    }
+
+    if (piece.outline.length() < 3)
+    {
+        handle_newConsoleText("The selected file has no closed outline.", Qt::darkRed);
+        return;
+    }
 
-    hpglModel->dataGroup(index, itemGroup);
+    // Scene x is along the roll, remnants keep x across it
+    for (int i = 0; i < piece.outline.length(); ++i)
+    {
+        piece.outline[i] = QPointF(piece.outline.at(i).y(), piece.outline.at(i).x());
+    }
+    piece.outline.translate(-piece.outline.boundingRect().topLeft());
+
+    piece.name = QInputDialog::getText(this, "Add Remnant", "Name:", QLineEdit::Normal,
+                                       list.first().data(Qt::DisplayRole).toString(), &ok);
+    if (!ok)
+    {
+        return;
+    }
+    hpglRemnants::add(piece);
+    handle_newConsoleText("Added remnant " + piece.name + " to the inventory.");
+}
+
+void MainWindow::do_removeRemnant()
+{
+    QVector<remnant_piece> pieces = hpglRemnants::load();
+    QStringList names;
+    bool ok;
+
+    if (pieces.isEmpty())
+    {
+        handle_newConsoleText("The remnant inventory is empty.", Qt::darkRed);
+        return;
+    }
+    for (int i = 0; i < pieces.length(); ++i)
+    {
+        QRectF bounds = pieces.at(i).outline.boundingRect();
+        names << pieces.at(i).name + " (" + QString::number(bounds.width() / 1016.0, 'f', 1) + " x "
+                 + QString::number(bounds.height() / 1016.0, 'f', 1) + " in)";
+    }
+    QString choice = QInputDialog::getItem(this, "Remove Remnant", "Remnant:", names, 0, false, &ok);
+    if (!ok)
+    {
+        return;
+    }
+    hpglRemnants::remove(names.indexOf(choice));
+    handle_newConsoleText("Removed remnant " + choice + " from the inventory.");
+}
+
+/**
+ * @brief MainWindow::plotPlan
+ * The order to plot in: the roll, or each length of it, then the remnants.
+ * @return - model panels, -1 for the roll
+ */
+QVector<int> MainWindow::plotPlan()
+{
+    QVector<hpgl_panel> panels = hpglModel->panels();
+    QVector<int> plan;
+    bool split = false;
+
+    for (int i = 0; i < panels.length(); ++i)
+    {
+        if (panels.at(i).roll)
+        {
+            plan.push_back(i);
+            split = true;
+        }
+    }
+    if (!split)
+    {
+        plan.push_back(-1);
+    }
+    for (int i = 0; i < panels.length(); ++i)
+    {
+        if (!panels.at(i).roll)
+        {
+            plan.push_back(i);
+        }
+    }
+    return(plan);
+}
+
+/**
+ * @brief MainWindow::do_splitRolls
+ * Splits the layout into roll lengths where it is, so rolls can be changed
+ * between plots without arranging again.
+ */
+void MainWindow::do_splitRolls()
+{
+    QSettings settings;
+    QString unit = "inches";
+    double scale = 1016.0;
+    bool ok;
+
+    if (settings.value("device/width/type", SETDEF_DEVICE_WDITH_TYPE).toInt() == deviceWidth_t::CM)
+    {
+        unit = "cm";
+        scale = 1016.0 / 2.54;
+    }
+
+    double length = QInputDialog::getDouble(this, "Split into Rolls", "Roll length (" + unit + "), 0 for one roll:",
+                                            settings.value("device/rolllength", SETDEF_DEVICE_ROLLLENGTH).toDouble(),
+                                            0, 100000, 1, &ok);
+    if (!ok)
+    {
+        return;
+    }
+    settings.setValue("device/rolllength", length);
+
+    bool tile = settings.value("device/rolllength/tile", SETDEF_DEVICE_ROLLLENGTH_TILE).toBool();
+    if (length > 0)
+    {
+        QMessageBox::StandardButton reply;
+        reply = QMessageBox::question(this, "Split into Rolls",
+                                      "Cut files that cross the end of a roll in two? "
+                                      "Otherwise each roll stops short of the first file that would cross it.",
+                                      QMessageBox::Yes | QMessageBox::No);
+        tile = (reply == QMessageBox::Yes);
+        settings.setValue("device/rolllength/tile", tile);
+    }
+
+    // Remnants stay as they are, only the roll is split
+    QVector<hpgl_panel> panels, remnants = hpglModel->panels();
+    for (int i = remnants.length()-1; i >= 0; --i)
+    {
+        if (remnants.at(i).roll)
+        {
+            remnants.remove(i);
+        }
+    }
+
+    QVector<QRectF> files;
+    for (int i = 0; i < hpglModel->rowCount(); ++i)
+    {
+        hpglFileItem * fileItem = NULL;
+        QPersistentModelIndex index = hpglModel->index(i);
+        if (hpglModel->panelAt(index) >= 0)
+        {
+            continue;
+        }
+        hpglModel->dataItem(index, fileItem);
+        if (fileItem == NULL)
+        {
+            continue;
+        }
+        hpglModel->mutexLock();
+        files.push_back(fileItem->sceneBoundingRect());
+        hpglModel->mutexUnlock();
+    }
+
+    int tiled = 0;
+    QLineF widthLine = get_widthLine();
+    panels = hpglRollSplitter::split(files, widthLine.p2().y() - widthLine.p1().y(), length * scale, tile, &tiled);
+    hpglModel->setPanels(panels + remnants);
+
+    if (panels.isEmpty())
+    {
+        handle_newConsoleText("The roll is no longer split.");
+        return;
+    }
+
+    // The plot plan
+    for (int i = 0; i < panels.length(); ++i)
+    {
+        int count = 0;
+        for (int j = 0; j < files.length(); ++j)
+        {
+            if (panels.at(i).rect.intersects(files.at(j)))
+            {
+                ++count;
+            }
+        }
+        handle_newConsoleText(panels.at(i).name + ": " + QString::number(panels.at(i).rect.left() / scale, 'f', 1)
+                              + " to " + QString::number(panels.at(i).rect.right() / scale, 'f', 1) + " " + unit
+                              + ", " + QString::number(count) + " files.");
+    }
+    handle_newConsoleText("Split into " + QString::number(panels.length()) + " rolls, "
+                          + QString::number(tiled) + " files cut across rolls.");
+}
+
+/**
+ * @brief MainWindow::handle_panelsChanged
+ * Outlines each remnant panel in the scene.
+ */
+void MainWindow::handle_panelsChanged()
+{
+    QVector<hpgl_panel> panels = hpglModel->panels();
+    QPen pen;
+
+    for (int i = 0; i < panelItems.length(); ++i)
+    {
+        plotScene.removeItem(panelItems.at(i));
+        delete panelItems.at(i);
+    }
+    panelItems.clear();
+    plotPlanNext = 0;
+
+    pen.setCosmetic(true);
+    pen.setColor(QColor(150, 150, 150));
+    pen.setWidth(2);
+    pen.setStyle(Qt::DashLine);
+    for (int i = 0; i < panels.length(); ++i)
+    {
+        QGraphicsPolygonItem * item = plotScene.addPolygon(panels.at(i).outline, pen);
+        item->setToolTip(panels.at(i).name);
+        item->setZValue(-50);
+        panelItems.push_back(item);
+    }
+}
+
+/**
+ * @brief MainWindow::handle_nestedItem
+ * Places a file with the exact item to scene transform the nester chose.
+ */
+void MainWindow::handle_nestedItem(QPersistentModelIndex index, QTransform transform)
+{
+    hpglFileItem * fileItem;
+    fileItem = NULL;
+
+    hpglModel->dataItem(index, fileItem);
     hpglModel->mutexLock();
 
-    if (itemGroup == NULL)
+    if (fileItem == NULL)
     {
-        qDebug() << "Error: itemgroup is null in scenescalecontainselected().";
+        qDebug() << "Error: file item is null in handle_nestedItem().";
         hpglModel->mutexUnlock();
         return;
     }
 
-    double padding = settings.value("device/cutoutboxes/padding", SETDEF_DEVICE_CUTOUTBOXES_PADDING).toDouble();
-    if (settings.value("device/width/type", SETDEF_DEVICE_WDITH_TYPE).toInt() == deviceWidth_t::CM)
+    fileItem->setPos(0, 0);
+    fileItem->setRotation(0);
+    fileItem->setTransformOriginPoint(0, 0);
+    fileItem->setTransform(transform);
+
+    hpglModel->mutexUnlock();
+    hpglModel->setPlaced(index, true);
+}
+
+/**
+ * @brief MainWindow::handle_rotatedItem
+ * Gives a file a new item to scene transform about its centre, and redraws
+ * its cutout box square to the vinyl.
+ */
+void MainWindow::handle_rotatedItem(QPersistentModelIndex index, QTransform transform)
+{
+    QSettings settings;
+    hpglFileItem * fileItem;
+    fileItem = NULL;
+
+    bool cutoutBoxes = settings.value("device/cutoutboxes", SETDEF_DEVICE_CUTOUTBOXES).toBool();
+    if (cutoutBoxes)
+    {
+        hpglModel->removeCutoutBox(index);
+    }
+
+    hpglModel->dataItem(index, fileItem);
+    hpglModel->mutexLock();
+
+    if (fileItem == NULL)
     {
-        padding = padding * 2.54;
+        qDebug() << "Error: file item is null in handle_rotatedItem().";
+        hpglModel->mutexUnlock();
+        return;
     }
-    padding = padding * 1016.0;
 
-    if (static_cast<int>(itemGroup->sceneBoundingRect().width()) != static_cast<int>(rect.width()-(padding))
-            && static_cast<int>(itemGroup->sceneBoundingRect().width()) == static_cast<int>(rect.height()-(padding)))
+    QPointF centre = fileItem->sceneBoundingRect().center();
+    fileItem->setPos(0, 0);
+    fileItem->setRotation(0);
+    fileItem->setTransformOriginPoint(0, 0);
+    fileItem->setTransform(transform);
+    fileItem->setPos(centre - fileItem->sceneBoundingRect().center());
+
+    hpglModel->mutexUnlock();
+
+    if (cutoutBoxes)
+    {
+        hpglModel->createCutoutBox(index);
+    }
+}
+
+/**
+ * @brief MainWindow::handle_sceneMouseReleased
+ * Whatever the operator just dragged is placed by hand.
+ */
+void MainWindow::handle_sceneMouseReleased()
+{
+    hpglModel->placeSelectedItems();
+}
+
+void MainWindow::handle_packedRect(QPersistentModelIndex index, QRectF rect)
+{
+    hpglFileItem * fileItem;
+    fileItem = NULL;
+
+    hpglModel->dataItem(index, fileItem);
+    hpglModel->mutexLock();
+
+    if (fileItem == NULL)
+    {
+        qDebug() << "Error: file item is null in scenescalecontainselected().";
+        hpglModel->mutexUnlock();
+        return;
+    }
+
+    double padding = ExtBinPack::packMargin();
+
+    if (static_cast<int>(fileItem->sceneBoundingRect().width()) != static_cast<int>(rect.width()-(padding))
+            && static_cast<int>(fileItem->sceneBoundingRect().width()) == static_cast<int>(rect.height()-(padding)))
     {
         int translateWidth, translateheight;
         QTransform transform;
-        translateWidth = itemGroup->boundingRect().width();
-        translateheight = itemGroup->boundingRect().height();
+        translateWidth = fileItem->boundingRect().width();
+        translateheight = fileItem->boundingRect().height();
         transform.translate(translateWidth/2.0, translateheight/2.0);
         transform.rotate(90);
         transform.translate(-translateWidth/2.0, -translateheight/2.0);
-        itemGroup->setTransform(itemGroup->transform() * transform);
+        fileItem->setTransform(fileItem->transform() * transform);
         hpglModel->mutexUnlock();
         sceneConstrainItems();
         hpglModel->mutexLock();
@@ -661,16 +1257,17 @@ void MainWindow::handle_packedRect(QPersistentModelIndex index, QRectF rect)
     QPointF posFinal, posItem, posScene;
     QRectF grect;
     posFinal = QPointF(rect.x(), rect.y());
-    posItem = itemGroup->pos();
-    grect = itemGroup->sceneBoundingRect();
+    posItem = fileItem->pos();
+    grect = fileItem->sceneBoundingRect();
     posScene = grect.topLeft();
     qDebug() << posFinal << posItem << posScene;
     posItem.setX(posItem.x() + (posFinal.x() - posScene.x()));
     posItem.setY(posItem.y() + (posFinal.y() - posScene.y()));
     qDebug() << posItem;
-    itemGroup->setPos(posItem);
+    fileItem->setPos(posItem);
 
     hpglModel->mutexUnlock();
+    hpglModel->setPlaced(index, true);
 }
 
 void MainWindow::do_cancelPlot()
@@ -681,14 +1278,14 @@ void MainWindow::do_cancelPlot()
 
 void MainWindow::handle_duplicateFileBtn()
 {
-    QFuture<void> tThread = QtConcurrent::run(this->hpglModel, &hpglListModel::duplicateSelectedRows);
+    // Copies share their geometry, so this is quick enough for the main thread
+    hpglModel->duplicateSelectedRows();
 }
 
 void MainWindow::handle_plotSceneSelectionChanged()
 {
     QModelIndex index;
-    QGraphicsItemGroup * itemGroup;
-    QVector<QGraphicsPolygonItem *> * items;
+    hpglFileItem * fileItem;
     QPen _selectedPen;
 
     ui->listView->selectionModel()->clearSelection();
@@ -696,42 +1293,32 @@ void MainWindow::handle_plotSceneSelectionChanged()
     for (int i = 0; i < hpglModel->rowCount(); ++i)
     {
         index = hpglModel->index(i);
-        itemGroup = NULL;
-        items = NULL;
-        hpglModel->dataItemsGroup(index, itemGroup, items);
+        fileItem = NULL;
+        hpglModel->dataItem(index, fileItem);
         hpglModel->mutexLock();
 
-        if (itemGroup == NULL)
-        {
-            qDebug() << "Error: itemgroup is null in scenescalecontainselected().";
-            hpglModel->mutexUnlock();
-            return;
-        }
-        if (items == NULL)
+        if (fileItem == NULL)
         {
-            qDebug() << "Error: items is null in scenescalecontainselected().";
+            qDebug() << "Error: file item is null in scenescalecontainselected().";
             hpglModel->mutexUnlock();
             return;
         }
 
         get_pen(&_selectedPen, "down");
 
-        if (itemGroup->isSelected())
+        if (fileItem->isSelected())
         {
             ui->listView->selectionModel()->select(index, QItemSelectionModel::Select);
-            itemGroup->setZValue(1);
+            fileItem->setZValue(1);
             _selectedPen.setColor(_selectedPen.color().lighter(120));
         }
         else
         {
             ui->listView->selectionModel()->select(index, QItemSelectionModel::Deselect);
-            itemGroup->setZValue(-1);
+            fileItem->setZValue(-1);
         }
 
-        for (int i3 = 0; i3 < items->length(); ++i3)
-        {
-            (*items)[i3]->setPen(_selectedPen);
-        }
+        fileItem->setPen(_selectedPen);
         hpglModel->mutexUnlock();
     }
 }
@@ -740,8 +1327,7 @@ void MainWindow::handle_listViewClick()
 {
     QModelIndexList list;
     QModelIndex index;
-    QGraphicsItemGroup * itemGroup;
-    QVector<QGraphicsPolygonItem *> * items;
+    hpglFileItem * fileItem;
     QPen _selectedPen;
 
     list = ui->listView->selectionModel()->selectedIndexes();
@@ -750,20 +1336,13 @@ void MainWindow::handle_listViewClick()
     for (int i = 0; i < hpglModel->rowCount(); ++i)
     {
         index = hpglModel->index(i);
-        itemGroup = NULL;
-        items = NULL;
-        hpglModel->dataItemsGroup(index, itemGroup, items);
+        fileItem = NULL;
+        hpglModel->dataItem(index, fileItem);
         hpglModel->mutexLock();
 
-        if (itemGroup == NULL)
+        if (fileItem == NULL)
         {
-            qDebug() << "Error: itemgroup is null in scenescalecontainselected().";
-            hpglModel->mutexUnlock();
-            return;
-        }
-        if (items == NULL)
-        {
-            qDebug() << "Error: items is null in scenescalecontainselected().";
+            qDebug() << "Error: file item is null in scenescalecontainselected().";
             hpglModel->mutexUnlock();
             return;
         }
@@ -774,21 +1353,18 @@ void MainWindow::handle_listViewClick()
 
         if (selectionmodel->isSelected(index))
         {
-            itemGroup->setSelected(true);
-            itemGroup->setZValue(1);
+            fileItem->setSelected(true);
+            fileItem->setZValue(1);
             _selectedPen.setColor(_selectedPen.color().lighter(120));
         }
         else
         {
-            itemGroup->setSelected(false);
-            itemGroup->setZValue(-1);
+            fileItem->setSelected(false);
+            fileItem->setZValue(-1);
         }
 
         hpglModel->mutexLock();
-        for (int i3 = 0; i3 < items->length(); ++i3)
-        {
-            (*items)[i3]->setPen(_selectedPen);
-        }
+        fileItem->setPen(_selectedPen);
         hpglModel->mutexUnlock();
     }
 }
@@ -796,7 +1372,7 @@ void MainWindow::handle_listViewClick()
 void MainWindow::newFileToScene(QPersistentModelIndex _index)
 {
     QSettings settings;
-    QGraphicsItemGroup * itemGroup = NULL;
+    hpglFileItem * fileItem = NULL;
 
     if (!_index.isValid())
     {
@@ -810,25 +1386,25 @@ void MainWindow::newFileToScene(QPersistentModelIndex _index)
         hpglModel->createCutoutBox(_index);
     }
 
-    hpglModel->dataGroup(_index, itemGroup);
+    hpglModel->dataItem(_index, fileItem);
     hpglModel->mutexLock();
 
-    if (itemGroup == NULL)
+    if (fileItem == NULL)
     {
-        qDebug() << "Error: itemgroup is null in newFileToScene().";
+        qDebug() << "Error: file item is null in newFileToScene().";
+        hpglModel->mutexUnlock();
         return;
     }
 
-    plotScene.addItem(itemGroup);
+    plotScene.addItem(fileItem);
     hpglModel->mutexUnlock();
 
-    hpglModel->setGroupFlag(_index, QGraphicsItem::ItemIsMovable, true);
-    hpglModel->setGroupFlag(_index, QGraphicsItem::ItemIsSelectable, true);
+    hpglModel->setItemFlag(_index, QGraphicsItem::ItemIsMovable, true);
+    hpglModel->setItemFlag(_index, QGraphicsItem::ItemIsSelectable, true);
 
     ui->listView->selectionModel()->clearSelection();
     handle_listViewClick();
-    itemGroup->setSelected(true);
-    hpglModel->mutexUnlock();
+    fileItem->setSelected(true);
 
     handle_plotSceneSelectionChanged();
     sceneConstrainItems();
@@ -838,39 +1414,28 @@ void MainWindow::handle_deleteFileBtn()
 {
     QModelIndexList list;
     QModelIndex index;
-    QGraphicsItemGroup * itemGroup;
-    QVector<QGraphicsPolygonItem *> * items;
+    hpglFileItem * fileItem;
 
     list = ui->listView->selectionModel()->selectedIndexes();
 
     for (int i = list.length()-1; i >= 0; --i)
     {
         index = list.at(i);
-        itemGroup = NULL;
-        items = NULL;
-        hpglModel->dataItemsGroup(index, itemGroup, items);
+        fileItem = NULL;
+        hpglModel->dataItem(index, fileItem);
         hpglModel->mutexLock();
 
-        if (itemGroup == NULL)
+        if (fileItem == NULL)
         {
-            qDebug() << "Error: itemgroup is null in scenescalecontainselected().";
-            hpglModel->mutexUnlock();
-            return;
-        }
-        if (items == NULL)
-        {
-            qDebug() << "Error: items is null in scenescalecontainselected().";
+            qDebug() << "Error: file item is null in scenescalecontainselected().";
             hpglModel->mutexUnlock();
             return;
         }
 
-        for (int i2 = items->length()-1; i2 >= 0; --i2)
-        {
-            plotScene.removeItem(items->at(i2));
-        }
+        plotScene.removeItem(fileItem);
         hpglModel->mutexUnlock();
 
-        plotScene.destroyItemGroup(itemGroup);
+        delete fileItem;
 
         hpglModel->removeRow(list[i].row());
     }
@@ -1069,15 +1634,8 @@ void MainWindow::sceneConstrainItems()
 
 void MainWindow::addPolygon(QPersistentModelIndex index, QPolygonF poly)
 {
-    // Variables
-    QPen pen;
-
-    // Set downPen
-    get_pen(&pen, "down");
-
-    QGraphicsPolygonItem * gpoly = plotScene.addPolygon(poly, pen);
-
-    hpglModel->addPolygon(index, gpoly);
+    // Pens are set when the file reaches the scene
+    hpglModel->addPolygon(index, poly);
 }
 
 
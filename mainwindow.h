@@ -41,6 +41,8 @@
 #include <QUrl>
 #include <qtconcurrentrun.h>
 #include <QGraphicsDropShadowEffect>
+#include <QMessageBox>
+#include <QInputDialog>
 
 #include <qmath.h>
 #include <unistd.h>
@@ -52,6 +54,9 @@
 #include "hpglgraphicsview.h"
 #include "hpgllistmodel.h"
 #include "ext/binpack.h"
+#include "ext/nest.h"
+#include "ext/optimize.h"
+#include "ext/rollsplit.h"
 #include "dialog/dialogprogress.h"
 
 QString timeStamp();
@@ -117,15 +122,30 @@ private slots:
     void addPolygon(QPersistentModelIndex index, QPolygonF poly);
     void newFileToScene(QPersistentModelIndex _index);
     void handle_packedRect(QPersistentModelIndex index, QRectF rect);
+    void handle_nestedItem(QPersistentModelIndex index, QTransform transform);
+    void handle_rotatedItem(QPersistentModelIndex index, QTransform transform);
+    void handle_sceneMouseReleased();
     void handle_cutoutBoxesToggle(bool checked);
     void setGrid();
 
     // plotter thread
     void do_plot();
+    void do_resumePlot();
+    void do_splitRolls();
     void do_jog();
     void do_cancelPlot();
     void do_procEta();
+    void do_calibrateEta();
+    void handle_sceneChangedEta();
     void do_binpack();
+    void do_binpackNew();
+    void do_nest();
+    void do_optimizeLayout();
+    void do_binpackRemnants();
+    void do_addRemnant();
+    void do_addRemnantFromSelection();
+    void do_removeRemnant();
+    void handle_panelsChanged();
 
     // URLs
     void handle_openSourceCode();
@@ -140,6 +160,9 @@ protected:
 
 private:
     QFrame * statusBarDivider();
+    void startPlot(ExtPlot * worker);
+    QVector<int> plotPlan();
+    void startBinpack(bool incremental, bool remnants = false);
     QPersistentModelIndex createHpglFile(file_uid _file);
 
     Ui::MainWindow *ui;
@@ -147,6 +170,9 @@ private:
     hpglListModel * hpglModel;
     QGraphicsLineItem * widthLine;
     QGraphicsRectItem * vinyl;
+    QVector<QGraphicsPolygonItem *> panelItems;
+    int plotPlanNext;       // step of the plot plan to offer next
+    eta_motion etaMotion;   // for handle_sceneChangedEta(), follows the settings
 
     // Status bar
     QLabel * label_eta;
@@ -37,6 +37,30 @@ static const char* deviceWidth_names[] = {"inch", "cm"};
 static_assert(sizeof(deviceWidth_names)/sizeof(char*) == deviceWidth_t::SIZE_OF_ENUM
     , "Settings device width sizes dont match");
 
+// Coordinate encoding used for plotter output
+enum deviceEncoding_t {
+    ENCODING_ABSOLUTE = 0,
+    ENCODING_RELATIVE,
+    ENCODING_POLYLINE,
+    ENCODING_SIZE_OF_ENUM
+};
+static const char* deviceEncoding_names[] = {"Absolute (PA)", "Relative (PR)", "HP-GL/2 Polyline Encoded (PE)"};
+
+static_assert(sizeof(deviceEncoding_names)/sizeof(char*) == deviceEncoding_t::ENCODING_SIZE_OF_ENUM
+    , "Settings device encoding sizes dont match");
+
+// Turning files to a tighter bounding box before auto arrange
+enum binpackRotation_t {
+    ROTATION_NONE = 0,
+    ROTATION_AREA,
+    ROTATION_WIDTH,
+    ROTATION_SIZE_OF_ENUM
+};
+static const char* binpackRotation_names[] = {"None", "Minimum area", "Minimum width"};
+
+static_assert(sizeof(binpackRotation_names)/sizeof(char*) == binpackRotation_t::ROTATION_SIZE_OF_ENUM
+    , "Settings bin pack rotation sizes dont match");
+
 /**
  * Settings Defaults
  */
@@ -57,6 +81,20 @@ static_assert(sizeof(deviceWidth_names)/sizeof(char*) == deviceWidth_t::SIZE_OF_
 #define SETDEF_DEVICE_WDITH_TYPE    (deviceWidth_t::INCH)
 #define SETDEF_DEVICE_CUTOUTBOXES   (false)
 #define SETDEF_DEVICE_CUTOUTBOXES_PADDING (0.25)
+#define SETDEF_DEVICE_CUTOUTBOXES_SHARED  (true)
+#define SETDEF_DEVICE_ENCODING      (deviceEncoding_t::ENCODING_ABSOLUTE)
+#define SETDEF_DEVICE_MOTION_ACCEL      (1500.0)
+#define SETDEF_DEVICE_MOTION_JUNCTION   (0.05)
+#define SETDEF_DEVICE_MOTION_PENDELAY   (40.0)
+#define SETDEF_DEVICE_MOTION_CMDDELAY   (5.0)
+#define SETDEF_DEVICE_SESSIONLOG        (true)
+#define SETDEF_DEVICE_SESSIONLOG_KEEP   (20)
+#define SETDEF_DEVICE_BUFFER            (8192)
+#define SETDEF_DEVICE_ROLLLENGTH        (0.0)
+#define SETDEF_DEVICE_ROLLLENGTH_TILE   (true)
+#define SETDEF_DEVICE_ROLLLENGTH_MARKS  (true)
+#define SETDEF_DEVICE_DEDUP             (true)
+#define SETDEF_DEVICE_DEDUP_TOLERANCE   (0.1)
 
 #define SETDEF_MAINWINDOW_FILEPATH  ("")
 #define SETDEF_MAINWINDOW_GRID      (true)
@@ -83,6 +121,19 @@ static_assert(sizeof(deviceWidth_names)/sizeof(char*) == deviceWidth_t::SIZE_OF_
 #define SETDEF_SERIAL_XONOFF    (false)
 #define SETDEF_SERIAL_RTSCTS    (false)
 
+#define SETDEF_BINPACK_DEADLINE (3000)
+#define SETDEF_BINPACK_STRIP    (250)
+#define SETDEF_BINPACK_ROTATION (binpackRotation_t::ROTATION_NONE)
+
+#define SETDEF_OPTIMIZE_TIME    (10000)
+
+#define SETDEF_NEST_RESOLUTION  (2.0)
+#define SETDEF_NEST_ROTATIONS   (4)
+#define SETDEF_NEST_TIMEBUDGET  (10000)
+
+#define SETDEF_PLOT_CHECKPOINT          (false)
+#define SETDEF_PLOT_CHECKPOINT_STROKE   (0)
+
 /**
  * Current Settings Paths:
  *
@@ -110,6 +161,51 @@ static_assert(sizeof(deviceWidth_names)/sizeof(char*) == deviceWidth_t::SIZE_OF_
  * - - type (enum)
  * - cutoutboxes (bool)
  * - - padding (double)
+ * - - shared (bool)
+ * - encoding (enum)
+ * - motion
+ * - - accel (double, mm/s^2)
+ * - - junction (double, mm)
+ * - - pendelay (double, ms)
+ * - - cmddelay (double, ms)
+ * - sessionlog (bool)
+ * - - keep (int, newest session logs kept)
+ * - buffer (int, bytes the OS, port and device hold after the serial driver)
+ * - rolllength (double, width units, 0 for one roll)
+ * - - tile (bool)
+ * - - marks (bool)
+ * - dedup (bool)
+ * - - tolerance (double, mm)
+ * - profiles
+ * - - <port>
+ * - - - cutscale (double)
+ * - - - travelscale (double)
+ * - - - accel (double, mm/s^2)
+ * - - - pendelay (double, ms)
+ *
+ * binpack
+ * - deadline (int, ms)
+ * - strip (int, ms)
+ * - rotation (enum)
+ *
+ * optimize
+ * - time (int, ms)
+ *
+ * nest
+ * - resolution (double, mm)
+ * - rotations (int)
+ * - timebudget (int, ms)
+ *
+ * remnants (array)
+ * - name (string)
+ * - outline (polygon, plotter units, x across the roll)
+ *
+ * plot
+ * - checkpoint (bool)
+ * - - stroke (int, first stroke that may not have been plotted)
+ * - - file (int)
+ * - - offset (int)
+ * - - total (int)
  *
  * mainwindow
  * - filePath (string)
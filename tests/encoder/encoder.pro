@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# hpglEncoder output decoded back like the loader does
+#
+#-------------------------------------------------
+
+QT       += core gui testlib
+
+TARGET = tst_encoder
+TEMPLATE = app
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+INCLUDEPATH += ../.. \
+    ../../ext
+
+SOURCES += tst_encoder.cpp \
+    ../../ext/encoder.cpp
+
+HEADERS  += ../../ext/encoder.h
@@ -0,0 +1,185 @@
+/**
+ * tst_encoder - hpglEncoder output decoded back like the loader does
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include <QtTest>
+
+#include "encoder.h"
+
+class TestEncoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+
+private:
+    static QPolygon randomPolygon(int count, int range);
+    static bool decodeJob(const QByteArray & job, QVector<QPolygonF> & strokes);
+};
+
+/**
+ * @brief TestEncoder::randomPolygon
+ * Same points for the same count, so failures can be reproduced.
+ * Points fall in [-range, range) so deltas go both ways.
+ */
+QPolygon TestEncoder::randomPolygon(int count, int range)
+{
+    QPolygon poly;
+    quint32 seed = 12345 + count;
+
+    poly.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        int point[2];
+        for (int c = 0; c < 2; ++c)
+        {
+            seed = (seed * 1664525u) + 1013904223u;
+            point[c] = static_cast<int>(((seed >> 8) / 16777216.0) * range * 2) - range;
+        }
+        poly << QPoint(point[0], point[1]);
+    }
+    return(poly);
+}
+
+/**
+ * @brief TestEncoder::decodeJob
+ * Reads a job back the way ExtLoadFile::process does: PU/PD follow PA/PR,
+ * PE goes through hpglEncoder::decodePE, the pen carries between commands.
+ * Pen down runs of less than two points draw nothing and are dropped.
+ * @return - false on a command the loader would reject
+ */
+bool TestEncoder::decodeJob(const QByteArray & job, QVector<QPolygonF> & strokes)
+{
+    QList<QByteArray> cmds = job.split(';');
+    QPointF tail(0, 0);
+    bool relative = false;
+
+    for (int i = 0; i < cmds.count(); ++i)
+    {
+        QByteArray cmd = cmds.at(i);
+        QByteArray opcode = cmd.left(2);
+        QList<QByteArray> values = cmd.mid(2).split(',');
+
+        if (cmd.isEmpty() || opcode == "IN" || opcode == "SP")
+        {
+            continue;
+        }
+        else if (opcode == "PA" || opcode == "PR")
+        {
+            relative = (opcode == "PR");
+        }
+        else if (opcode == "PU" || opcode == "PD")
+        {
+            QPolygonF stroke;
+            stroke << tail;
+            for (int i2 = 0; (i2+1) < values.count(); i2 += 2)
+            {
+                QPointF point(values.at(i2).toInt(), values.at(i2+1).toInt());
+                tail = relative ? (tail + point) : point;
+                stroke << tail;
+            }
+            if (opcode == "PD" && stroke.count() > 1)
+            {
+                strokes.push_back(stroke);
+            }
+        }
+        else if (opcode == "PE")
+        {
+            if (!hpglEncoder::decodePE(cmd.mid(2), tail, strokes))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestEncoder::roundTrip_data()
+{
+    QTest::addColumn<int>("encoding");
+    QTest::addColumn<QVector<QPolygon> >("strokes");
+    QTest::addColumn<int>("seekBefore");
+
+    QVector<QPolygon> negative;
+    negative << (QPolygon() << QPoint(5000, 5000) << QPoint(100, 4000) << QPoint(-300, -20) << QPoint(7, -9000));
+    negative << (QPolygon() << QPoint(200, 200) << QPoint(0, 0) << QPoint(-1, -1));
+
+    QVector<QPolygon> zeroLength;
+    zeroLength << (QPolygon() << QPoint(10, 10) << QPoint(10, 10));
+    zeroLength << (QPolygon() << QPoint(10, 10) << QPoint(10, 10) << QPoint(10, 10));
+    zeroLength << (QPolygon() << QPoint(50, 50));
+    zeroLength << (QPolygon() << QPoint(50, 50) << QPoint(60, 60));
+    zeroLength << (QPolygon() << QPoint(0, 0) << QPoint(0, 0));
+
+    QVector<QPolygon> large;
+    large << (QPolygon() << QPoint(1000000000, -1000000000) << QPoint(-1000000000, 1000000000));
+    large << (QPolygon() << QPoint(-1000000000, 1000000000) << QPoint(1000000000, 1000000000) << QPoint(0, 0));
+    large << (QPolygon() << QPoint(16383, 16384) << QPoint(-16384, 1048575) << QPoint(1048576, -33554432));
+
+    QVector<QPolygon> chained;
+    chained << (QPolygon() << QPoint(100, 100) << QPoint(200, 100));
+    chained << (QPolygon() << QPoint(200, 100) << QPoint(200, 300));
+    chained << (QPolygon() << QPoint(200, 300) << QPoint(100, 100));
+
+    QVector<QPolygon> random;
+    random << randomPolygon(1001, 40000) << randomPolygon(2, 40000) << randomPolygon(33, 40000);
+
+    for (int encoding = ENCODING_RELATIVE; encoding <= ENCODING_POLYLINE; ++encoding)
+    {
+        QString name = (encoding == ENCODING_RELATIVE) ? "PR " : "PE ";
+        QTest::newRow(qPrintable(name + "negative deltas")) << encoding << negative << -1;
+        QTest::newRow(qPrintable(name + "zero length")) << encoding << zeroLength << -1;
+        QTest::newRow(qPrintable(name + "large coordinates")) << encoding << large << -1;
+        QTest::newRow(qPrintable(name + "chained")) << encoding << chained << -1;
+        QTest::newRow(qPrintable(name + "resume")) << encoding << chained << 1;
+        QTest::newRow(qPrintable(name + "random")) << encoding << random << -1;
+    }
+}
+
+/**
+ * @brief TestEncoder::roundTrip
+ * A whole job, preamble to trailer, has to decode back to the strokes it
+ * was made from. seekBefore resumes at that stroke like a restarted plot.
+ */
+void TestEncoder::roundTrip()
+{
+    QFETCH(int, encoding);
+    QFETCH(QVector<QPolygon>, strokes);
+    QFETCH(int, seekBefore);
+
+    hpglEncoder encoder(static_cast<deviceEncoding_t>(encoding));
+    QByteArray job = encoder.begin();
+    QVector<QPolygon> expected;
+    for (int i = 0; i < strokes.count(); ++i)
+    {
+        if (i == seekBefore)
+        {
+            job += encoder.seek(strokes.at(i).first());
+        }
+        job += encoder.stroke(strokes.at(i));
+        if (strokes.at(i).count() > 1)
+        {
+            expected.push_back(strokes.at(i));
+        }
+    }
+    QCOMPARE(encoder.position(), strokes.last().last());
+    job += encoder.end();
+
+    QVector<QPolygonF> decoded;
+    QVERIFY2(decodeJob(job, decoded), job.constData());
+    QCOMPARE(decoded.count(), expected.count());
+    for (int i = 0; i < decoded.count(); ++i)
+    {
+        QCOMPARE(decoded.at(i).toPolygon(), expected.at(i));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestEncoder)
+
+#include "tst_encoder.moc"
@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# hpglGeometry kernels against their scalar references
+#
+#-------------------------------------------------
+
+QT       += core gui testlib
+
+TARGET = tst_geometry
+TEMPLATE = app
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+INCLUDEPATH += ../../ext
+
+SOURCES += tst_geometry.cpp \
+    ../../ext/geometry.cpp
+
+HEADERS  += ../../ext/geometry.h
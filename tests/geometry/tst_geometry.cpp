@@ -0,0 +1,251 @@
+/**
+ * tst_geometry - hpglGeometry kernels against their scalar references
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include <QtTest>
+
+#include "geometry.h"
+
+// Points per benchmark run
+#define BENCH_POINTS (100000)
+
+// Ways to get a file's strokes into plotter units
+enum mapMethod_t {
+    MAP_SIMD = 0,
+    MAP_SCALAR,
+    MAP_PER_POINT
+};
+
+// Polyline length kernels
+enum lengthKernel_t {
+    LENGTH_SCALAR = 0,
+    LENGTH_SSE2,
+    LENGTH_AVX
+};
+
+class TestGeometry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void mapToDevice_data();
+    void mapToDevice();
+    void mapToDeviceBenchmark_data();
+    void mapToDeviceBenchmark();
+    void polylineLength_data();
+    void polylineLength();
+    void polylineLengthBenchmark_data();
+    void polylineLengthBenchmark();
+
+private:
+    static QPolygonF randomPolygon(int count, double range);
+    static bool lengthKernel(int kernel, const QPolygonF & poly, double & length);
+};
+
+/**
+ * @brief TestGeometry::randomPolygon
+ * Same points for the same count, so failures can be reproduced.
+ */
+QPolygonF TestGeometry::randomPolygon(int count, double range)
+{
+    QPolygonF poly;
+    quint32 seed = 12345 + count;
+
+    poly.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        double point[2];
+        for (int c = 0; c < 2; ++c)
+        {
+            seed = (seed * 1664525u) + 1013904223u;
+            point[c] = ((seed >> 8) / 16777216.0) * range;
+        }
+        poly << QPointF(point[0], point[1]);
+    }
+    return(poly);
+}
+
+void TestGeometry::mapToDevice_data()
+{
+    QTest::addColumn<QTransform>("transform");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("empty") << QTransform() << 0;
+    QTest::newRow("one point") << QTransform().translate(10.5, 20.5) << 1;
+    QTest::newRow("identity") << QTransform() << 1001;
+    QTest::newRow("translate") << QTransform().translate(1016.25, 3.75) << 1001;
+    QTest::newRow("scale") << QTransform().scale(1.5, 0.75) << 1001;
+    QTest::newRow("rotate") << QTransform().translate(30000, 30000).rotate(37) << 1001;
+    QTest::newRow("mirror") << QTransform().translate(30000, 0).scale(-1, 1) << 1001;
+    QTest::newRow("out of bounds") << QTransform().translate(-500, -500) << 1001;
+}
+
+/**
+ * @brief TestGeometry::mapToDevice
+ * The SIMD path has to truncate and bounds check exactly like the scalar one.
+ */
+void TestGeometry::mapToDevice()
+{
+    QFETCH(QTransform, transform);
+    QFETCH(int, count);
+
+    QPolygonF poly = randomPolygon(count, 20000);
+    QPolygon simd, scalar;
+    bool simdOk = hpglGeometry::mapToDevice(transform, poly, simd);
+    bool scalarOk = hpglGeometry::mapToDeviceScalar(transform, poly, scalar);
+
+    QCOMPARE(simdOk, scalarOk);
+    QCOMPARE(simd, scalar);
+}
+
+void TestGeometry::mapToDeviceBenchmark_data()
+{
+    QTest::addColumn<int>("method");
+
+    QTest::newRow("mapToDevice") << (int)MAP_SIMD;
+    QTest::newRow("mapToDeviceScalar") << (int)MAP_SCALAR;
+    QTest::newRow("per point") << (int)MAP_PER_POINT;
+}
+
+/**
+ * @brief TestGeometry::mapToDeviceBenchmark
+ * BENCH_POINTS points per iteration. The per point row recomposes the
+ * transform for every point, like QGraphicsItem::mapToScene() does.
+ */
+void TestGeometry::mapToDeviceBenchmark()
+{
+    QFETCH(int, method);
+
+    QPolygonF poly = randomPolygon(BENCH_POINTS, 20000);
+    QTransform item = QTransform().rotate(30).scale(1.5, 1.5);
+    QTransform scene = QTransform().translate(40000, 1000);
+    QTransform transform = item * scene;
+    QPolygon points;
+
+    QBENCHMARK
+    {
+        if (method == MAP_SIMD)
+        {
+            hpglGeometry::mapToDevice(transform, poly, points);
+        }
+        else if (method == MAP_SCALAR)
+        {
+            hpglGeometry::mapToDeviceScalar(transform, poly, points);
+        }
+        else
+        {
+            points.resize(poly.count());
+            for (int i = 0; i < poly.count(); ++i)
+            {
+                QPointF point = (item * scene).map(poly.at(i));
+                points[i] = QPoint(static_cast<int>(point.x()), static_cast<int>(point.y()));
+            }
+        }
+    }
+    QCOMPARE(points.count(), poly.count());
+}
+
+/**
+ * @brief TestGeometry::lengthKernel
+ * Runs one kernel directly, whatever polylineLength() would pick here.
+ * @return - false if this build or CPU doesn't have it
+ */
+bool TestGeometry::lengthKernel(int kernel, const QPolygonF & poly, double & length)
+{
+    const double * src = reinterpret_cast<const double *>(poly.constData());
+
+    if (kernel == LENGTH_SCALAR)
+    {
+        length = hpglGeometry::polylineLengthScalar(poly);
+        return true;
+    }
+#if defined(__SSE2__)
+    if (kernel == LENGTH_SSE2)
+    {
+        length = hpglGeometry::polylineLengthSSE2(src, poly.count());
+        return true;
+    }
+#endif
+    if (kernel == LENGTH_AVX && hpglGeometry::hasAVX())
+    {
+        length = hpglGeometry::polylineLengthAVX(src, poly.count());
+        return true;
+    }
+    Q_UNUSED(src);
+    return false;
+}
+
+void TestGeometry::polylineLength_data()
+{
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<int>("count");
+
+    // Every tail length of both kernels, then something longer
+    for (int kernel = LENGTH_SSE2; kernel <= LENGTH_AVX; ++kernel)
+    {
+        QString name = (kernel == LENGTH_SSE2) ? "SSE2" : "AVX";
+        for (int count = 2; count <= 11; ++count)
+        {
+            QTest::newRow(qPrintable(name + " " + QString::number(count))) << kernel << count;
+        }
+        QTest::newRow(qPrintable(name + " 1001")) << kernel << 1001;
+    }
+}
+
+/**
+ * @brief TestGeometry::polylineLength
+ * The SIMD kernels add in a different order, so they only have to match
+ * the scalar reference to rounding.
+ */
+void TestGeometry::polylineLength()
+{
+    QFETCH(int, kernel);
+    QFETCH(int, count);
+
+    QPolygonF poly = randomPolygon(count, 20000);
+    double length;
+    if (!lengthKernel(kernel, poly, length))
+    {
+        QSKIP("Kernel not available on this build or CPU");
+    }
+    double reference = hpglGeometry::polylineLengthScalar(poly);
+
+    QVERIFY(reference > 0);
+    QVERIFY(qAbs(length - reference) <= (reference * 1e-12));
+    QVERIFY(qAbs(hpglGeometry::polylineLength(poly) - reference) <= (reference * 1e-12));
+}
+
+void TestGeometry::polylineLengthBenchmark_data()
+{
+    QTest::addColumn<int>("kernel");
+
+    QTest::newRow("scalar") << (int)LENGTH_SCALAR;
+    QTest::newRow("SSE2") << (int)LENGTH_SSE2;
+    QTest::newRow("AVX") << (int)LENGTH_AVX;
+}
+
+/**
+ * @brief TestGeometry::polylineLengthBenchmark
+ * BENCH_POINTS points per iteration.
+ */
+void TestGeometry::polylineLengthBenchmark()
+{
+    QFETCH(int, kernel);
+
+    QPolygonF poly = randomPolygon(BENCH_POINTS, 20000);
+    double length = 0;
+    if (!lengthKernel(kernel, poly, length))
+    {
+        QSKIP("Kernel not available on this build or CPU");
+    }
+
+    QBENCHMARK
+    {
+        lengthKernel(kernel, poly, length);
+    }
+    QVERIFY(length > 0);
+}
+
+QTEST_APPLESS_MAIN(TestGeometry)
+
+#include "tst_geometry.moc"
@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# hpglStripPacker layouts checked for overlaps, and timed
+#
+#-------------------------------------------------
+
+QT       += core testlib
+
+TARGET = tst_strippack
+TEMPLATE = app
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+INCLUDEPATH += ../../ext
+
+SOURCES += tst_strippack.cpp \
+    ../../ext/strippack.cpp
+
+HEADERS  += ../../ext/strippack.h
@@ -0,0 +1,187 @@
+/**
+ * tst_strippack - hpglStripPacker layouts checked for overlaps, and timed
+ * Christopher Bero <bigbero@gmail.com>
+ */
+#include <QtTest>
+
+#include "strippack.h"
+
+// Rectangles per benchmark run
+#define BENCH_RECTS (2000)
+
+// Strip width, two feet of roll in plotter units
+#define STRIP_WIDTH (24384)
+
+class TestStripPack : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void pack_data();
+    void pack();
+    void packTooWide();
+    void optimize();
+    void packBenchmark();
+
+private:
+    static QVector<QSizeF> randomSizes(int count, double range);
+    static void checkLayout(const QVector<QSizeF> & sizes, const QVector<QRectF> & rects,
+                            double length, int turn);
+};
+
+/**
+ * @brief TestStripPack::randomSizes
+ * Same sizes for the same count, so failures can be reproduced.
+ * Sizes have fractions so the packer's rounding up is exercised.
+ */
+QVector<QSizeF> TestStripPack::randomSizes(int count, double range)
+{
+    QVector<QSizeF> sizes;
+    quint32 seed = 12345 + count;
+
+    sizes.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        double side[2];
+        for (int c = 0; c < 2; ++c)
+        {
+            seed = (seed * 1664525u) + 1013904223u;
+            side[c] = 0.5 + ((seed >> 8) / 16777216.0) * range;
+        }
+        sizes << QSizeF(side[0], side[1]);
+    }
+    return(sizes);
+}
+
+/**
+ * @brief TestStripPack::checkLayout
+ * Every rectangle has its size rounded up, possibly turned, sits inside the
+ * strip and the reported length, and shares no area with any other.
+ */
+void TestStripPack::checkLayout(const QVector<QSizeF> & sizes, const QVector<QRectF> & rects,
+                                double length, int turn)
+{
+    double used = 0;
+
+    QCOMPARE(rects.count(), sizes.count());
+    for (int i = 0; i < rects.count(); ++i)
+    {
+        const QRectF & rect = rects.at(i);
+        QSizeF upright(qCeil(sizes.at(i).width()), qCeil(sizes.at(i).height()));
+
+        if (turn == hpglStripPacker::TURN_UPRIGHT)
+        {
+            QCOMPARE(rect.size(), upright);
+        }
+        else
+        {
+            QVERIFY(rect.size() == upright || rect.size() == upright.transposed());
+        }
+        QVERIFY(rect.left() >= 0);
+        QVERIFY(rect.right() <= STRIP_WIDTH);
+        QVERIFY(rect.top() >= 0);
+        QVERIFY(rect.bottom() <= length);
+        used = qMax(used, rect.bottom());
+
+        for (int i2 = i+1; i2 < rects.count(); ++i2)
+        {
+            if (rect.intersects(rects.at(i2)))
+            {
+                QFAIL(qPrintable(QString("Rectangles %1 and %2 overlap").arg(i).arg(i2)));
+            }
+        }
+    }
+    QCOMPARE(length, used);
+}
+
+void TestStripPack::pack_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("turn");
+
+    QTest::newRow("one") << 1 << (int)hpglStripPacker::TURN_ANY;
+    QTest::newRow("small") << 10 << (int)hpglStripPacker::TURN_ANY;
+    QTest::newRow("medium") << 200 << (int)hpglStripPacker::TURN_ANY;
+    QTest::newRow("large") << BENCH_RECTS << (int)hpglStripPacker::TURN_ANY;
+    QTest::newRow("large upright") << BENCH_RECTS << (int)hpglStripPacker::TURN_UPRIGHT;
+}
+
+/**
+ * @brief TestStripPack::pack
+ * One pass in longest side first order.
+ */
+void TestStripPack::pack()
+{
+    QFETCH(int, count);
+    QFETCH(int, turn);
+
+    QVector<QSizeF> sizes = randomSizes(count, 6000);
+    hpglStripPacker packer(STRIP_WIDTH);
+    QVector<QRectF> rects;
+    double length;
+
+    bool ok = packer.pack(sizes, hpglStripPacker::longestSideOrder(sizes), QVector<char>(count, turn),
+                          rects, length);
+    QVERIFY(ok);
+    checkLayout(sizes, rects, length, turn);
+}
+
+/**
+ * @brief TestStripPack::packTooWide
+ * Something wider than the strip both ways can't be placed at all.
+ */
+void TestStripPack::packTooWide()
+{
+    QVector<QSizeF> sizes = randomSizes(10, 6000);
+    hpglStripPacker packer(STRIP_WIDTH);
+    QVector<QRectF> rects;
+    double length;
+
+    sizes << QSizeF(STRIP_WIDTH + 0.5, STRIP_WIDTH + 1);
+    QVERIFY(!packer.pack(sizes, hpglStripPacker::longestSideOrder(sizes), rects, length));
+}
+
+/**
+ * @brief TestStripPack::optimize
+ * The search only keeps orders that aren't longer, so it can't lose to
+ * the single pass it starts from.
+ */
+void TestStripPack::optimize()
+{
+    QVector<QSizeF> sizes = randomSizes(200, 6000);
+    hpglStripPacker packer(STRIP_WIDTH);
+    QVector<QRectF> rects, firstRects;
+    double length, firstLength;
+
+    QVERIFY(packer.pack(sizes, hpglStripPacker::longestSideOrder(sizes), firstRects, firstLength));
+    QVERIFY(packer.optimize(sizes, 200, rects, length));
+    QVERIFY(packer.iterations() > 0);
+    QVERIFY(length <= firstLength);
+    checkLayout(sizes, rects, length, hpglStripPacker::TURN_ANY);
+}
+
+/**
+ * @brief TestStripPack::packBenchmark
+ * BENCH_RECTS rectangles per iteration, one pass each, the unit of work
+ * optimize() repeats.
+ */
+void TestStripPack::packBenchmark()
+{
+    QVector<QSizeF> sizes = randomSizes(BENCH_RECTS, 6000);
+    QVector<int> order = hpglStripPacker::longestSideOrder(sizes);
+    hpglStripPacker packer(STRIP_WIDTH);
+    QVector<QRectF> rects;
+    double length = 0;
+    bool ok = false;
+
+    QBENCHMARK
+    {
+        ok = packer.pack(sizes, order, rects, length);
+    }
+    QVERIFY(ok);
+    QVERIFY(length > 0);
+}
+
+QTEST_APPLESS_MAIN(TestStripPack)
+
+#include "tst_strippack.moc"
@@ -0,0 +1,11 @@
+#-------------------------------------------------
+#
+# Checks and benchmarks for the ext/ classes, run with make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += geometry \
+    encoder \
+    strippack